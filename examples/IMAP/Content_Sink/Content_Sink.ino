@@ -0,0 +1,259 @@
+/**
+ * This example shows how to read Email and forward the decoded content to the UART port at its own pace via the content sink.
+ *
+ * Email: suwatchai@outlook.com
+ *
+ * Github: https://github.com/mobizt/ESP-Mail-Client
+ *
+ * Copyright (c) 2022 mobizt
+ *
+ */
+
+/** Assign SD card type and FS used in src/ESP_Mail_FS.h and
+ * change the config for that card interfaces in src/addons/SDHelper.h
+ */
+
+#include <Arduino.h>
+#if defined(ESP32)
+#include <WiFi.h>
+#elif defined(ESP8266)
+#include <ESP8266WiFi.h>
+#else
+
+// Other Client defined here
+// To use custom Client, define ENABLE_CUSTOM_CLIENT in  src/ESP_Mail_FS.h.
+// See the example Custom_Client.ino for how to use.
+
+#endif
+
+#include <ESP_Mail_Client.h>
+
+// Provide the SD card interfaces setting and mounting
+#include <extras/SDHelper.h>
+
+#define WIFI_SSID "<ssid>"
+#define WIFI_PASSWORD "<password>"
+
+/** For Gmail, IMAP option should be enabled. https://support.google.com/mail/answer/7126229?hl=en
+ * and also https://accounts.google.com/b/0/DisplayUnlockCaptcha
+ *
+ * Some Gmail user still not able to sign in using account password even above options were set up,
+ * for this case, use "App Password" to sign in instead.
+ * About Gmail "App Password", go to https://support.google.com/accounts/answer/185833?hl=en
+ *
+ * For Yahoo mail, log in to your yahoo mail in web browser and generate app password by go to
+ * https://login.yahoo.com/account/security/app-passwords/add/confirm?src=noSrc
+ *
+ * To use Gmai and Yahoo's App Password to sign in, define the AUTHOR_PASSWORD with your App Password
+ * and AUTHOR_EMAIL with your account email.
+ */
+
+/* The imap host name e.g. imap.gmail.com for GMail or outlook.office365.com for Outlook */
+#define IMAP_HOST "<host>"
+
+/** The imap port e.g.
+ * 143  or esp_mail_imap_port_143
+ * 993 or esp_mail_imap_port_993
+ */
+#define IMAP_PORT 993
+
+/* The log in credentials */
+#define AUTHOR_EMAIL "<email>"
+#define AUTHOR_PASSWORD "<password>"
+
+/* The content sink that writes the decoded content to the UART port */
+class UARTSink : public MailContentSink
+{
+public:
+    UARTSink(HardwareSerial &serial) : _serial(serial) {}
+
+    void begin(const MIME_Data_Stream_Info &part) override
+    {
+        Serial.print("Message UID: ");
+        Serial.println(part.uid);
+
+        Serial.print("Content Type: ");
+        Serial.println(part.type);
+
+        Serial.print("File Name: ");
+        Serial.println(part.filename);
+    }
+
+    size_t write(const uint8_t *data, size_t len) override
+    {
+        // Accept only the data that fits in the UART transmit buffer,
+        // the rest of data will be written again later and
+        // the reading from server is paused until then.
+        size_t n = _serial.availableForWrite();
+        if (n > len)
+            n = len;
+        return _serial.write(data, n);
+    }
+
+    void end(bool complete) override
+    {
+        Serial.println(complete ? "Content forwarded" : "Content forwarding failed");
+        Serial.println();
+    }
+
+private:
+    HardwareSerial &_serial;
+};
+
+UARTSink uartSink(Serial1);
+
+/* The IMAP Session object used for Email reading */
+IMAPSession imap;
+
+void setup()
+{
+
+    Serial.begin(115200);
+
+#if defined(ARDUINO_ARCH_SAMD)
+    while (!Serial)
+        ;
+    Serial.println();
+    Serial.println("**** Custom built WiFiNINA firmware need to be installed.****\nTo install firmware, read the instruction here, https://github.com/mobizt/ESP-Mail-Client#install-custom-built-wifinina-firmware");
+
+#endif
+
+    Serial.println();
+
+    Serial.print("Connecting to AP");
+
+    WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
+    while (WiFi.status() != WL_CONNECTED)
+    {
+        Serial.print(".");
+        delay(200);
+    }
+
+    Serial.println("");
+    Serial.println("WiFi connected.");
+    Serial.println("IP address: ");
+    Serial.println(WiFi.localIP());
+    Serial.println();
+
+#if defined(ESP_MAIL_DEFAULT_SD_FS) // defined in src/ESP_Mail_FS.h
+    // Mount SD card.
+    SD_Card_Mounting(); // See src/addons/SDHelper.h
+#endif
+
+    Serial1.begin(9600);
+
+    /* Set the sink to receive the decoded content */
+    imap.setContentSink(&uartSink);
+
+    /** In case the SD card/adapter was used for the file storagge, the SPI pins can be configure from
+     * MailClient.sdBegin function which may be different for ESP32 and ESP8266
+     * For ESP32, assign all of SPI pins
+     * MailClient.sdBegin(14,2,15,13)
+     * Which SCK = 14, MISO = 2, MOSI = 15 and SS = 13
+     * And for ESP8266, assign the CS pins of SPI port
+     * MailClient.sdBegin(15)
+     * Which pin 15 is the CS pin of SD card adapter
+     */
+
+    /* Declare the session config data */
+    ESP_Mail_Session session;
+
+    /* Set the session config */
+    session.server.host_name = IMAP_HOST;
+    session.server.port = IMAP_PORT;
+    session.login.email = AUTHOR_EMAIL;
+    session.login.password = AUTHOR_PASSWORD;
+
+    /* Setup the configuration for searching or fetching operation and its result */
+    IMAP_Config config;
+
+    /* Set the storage to save the downloaded files and attachments */
+    config.storage.saved_path = F("/email_data");
+
+    /** The file storage type e.g.
+     * esp_mail_file_storage_type_none,
+     * esp_mail_file_storage_type_flash, and
+     * esp_mail_file_storage_type_sd
+     */
+    config.storage.type = esp_mail_file_storage_type_sd;
+
+    /** Set to download heades, text and html messaeges,
+     * attachments and inline images respectively.
+     */
+    config.download.header = true;
+    config.download.text = true;
+    config.download.html = true;
+    config.download.attachment = true;
+    config.download.inlineImg = true;
+
+    /** Set to enable the results i.e. html and text messaeges
+     * which the content stored in the IMAPSession object is limited
+     * by the option config.limit.msg_size.
+     * The whole message can be download through config.download.text
+     * or config.download.html which not depends on these enable options.
+     */
+    config.enable.html = true;
+    config.enable.text = true;
+
+    /* Set to enable the sort the result by message UID in the ascending order */
+    config.enable.recent_sort = true;
+
+    /* Set to report the download progress via the default serial port */
+    config.enable.download_status = true;
+
+    /* Header fields parsing is case insensitive by default to avoid uppercase header in some server e.g. iCloud
+    , to allow case sensitive parse, uncomment below line*/
+    // config.enable.header_case_sensitive = true;
+
+    /* Set the limit of number of messages in the search results */
+    config.limit.search = 5;
+
+    /** Set the maximum size of message stored in
+     * IMAPSession object in byte
+     */
+    config.limit.msg_size = 512;
+
+    /** Set the maximum attachments and inline images files size
+     * that can be downloaded in byte.
+     * The file which its size is largger than this limit may be saved
+     * as truncated file.
+     */
+    config.limit.attachment_size = 1024 * 1024 * 5;
+
+    /* Connect to server with the session and config */
+    if (!imap.connect(&session, &config))
+        return;
+
+    /* Open or select the mailbox folder to read or search the message */
+    if (!imap.selectFolder(F("INBOX")))
+        return;
+
+    /** Message UID to fetch or read e.g. 100.
+     * In this case we will get the UID from the max message number (lastest message)
+     */
+    config.fetch.uid = imap.getUID(imap.selectedFolder().msgCount());
+
+    /* Set seen flag */
+
+    // The message with "Seen" flagged means the message was already read or seen by user.
+    // The default value of this option is set to false.
+    // If you want to set the message flag as "Seen", set this option to true.
+    // If this option is false, the message flag was unchanged.
+    // To set or remove flag from message, see Set_Flags.ino example.
+
+    // config.fetch.set_seen = true;
+
+    /* Read or search the Email and close the session */
+
+    // When message was fetched or read, the /Seen flag will not set or message remained in unseen or unread status,
+    // as this is the purpose of library (not UI application), user can set the message status as read by set \Seen flag
+    // to message, see the Set_Flags.ino example.
+    MailClient.readMail(&imap);
+
+    /* Clear all stored data in IMAPSession object */
+    imap.empty();
+}
+
+void loop()
+{
+}
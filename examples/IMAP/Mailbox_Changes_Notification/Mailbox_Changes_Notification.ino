@@ -200,25 +200,27 @@ void printPollingStatus(IMAPSession &imap)
     /* Show the mailbox info */
     ESP_MAIL_PRINTF("\nMailbox status changed\n----------------------\nTotal Messages: %d\n", sFolder.msgCount());
 
-    if (sFolder.pollingStatus().type == imap_polling_status_type_new_message)
+    /* All changes received since the last check, in the order they were received */
+    for (size_t i = 0; i < sFolder.pollingStatusCount(); i++)
     {
+        IMAP_Polling_Status status = sFolder.pollingStatus(i);
 
-        ESP_MAIL_PRINTF("New message %d, has been addedd, reading message...\n", (int)sFolder.pollingStatus().messageNum);
+        if (status.type == imap_polling_status_type_new_message)
+        {
 
-        // if (sFolder.recentCount() > 0)
-        //     ESP_MAIL_PRINTF("\nMesssage count which recent flag set: %d\n", sFolder.recentCount());
+            ESP_MAIL_PRINTF("New message %d, has been addedd, reading message...\n", (int)status.messageNum);
 
-        // we need to stop polling before do anything
-        imap.stopListen();
+            // if (sFolder.recentCount() > 0)
+            //     ESP_MAIL_PRINTF("\nMesssage count which recent flag set: %d\n", sFolder.recentCount());
 
-        // Get the UID of new message and fetch
-        config.fetch.uid = imap.getUID(sFolder.pollingStatus().messageNum);
-        MailClient.readMail(&imap, false);
+            // Fetch all messages added since the last fetch, the listen is stopped and resumed internally
+            imap.fetchNewSinceIdle(false /* fetch the content as configured too */);
+        }
+        else if (status.type == imap_polling_status_type_remove_message)
+            ESP_MAIL_PRINTF("Message(s) %s, has been removed\n\n", status.argument.c_str());
+        else if (status.type == imap_polling_status_type_fetch_message)
+            ESP_MAIL_PRINTF("Message %d, has been fetched with the argument %s\n\n", (int)status.messageNum, status.argument.c_str());
     }
-    else if (sFolder.pollingStatus().type == imap_polling_status_type_remove_message)
-        ESP_MAIL_PRINTF("Message %d, has been removed\n\n", (int)sFolder.pollingStatus().messageNum);
-    else if (sFolder.pollingStatus().type == imap_polling_status_type_fetch_message)
-        ESP_MAIL_PRINTF("Message %d, has been fetched with the argument %s\n\n", (int)sFolder.pollingStatus().messageNum, sFolder.pollingStatus().argument.c_str());
 }
 
 void printSelectedMailboxInfo(IMAPSession &imap)
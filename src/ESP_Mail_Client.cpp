@@ -94,6 +94,18 @@ int ESP_Mail_Client::getFreeHeap()
 #endif
 }
 
+#if defined(ESP_MAIL_USE_TLS_SESSION_CACHE)
+TLS_Session_Cache_Stats ESP_Mail_Client::getTLSSessionCacheStats()
+{
+  return ESP_MAIL_TLS_SESSION_CACHE::stats();
+}
+
+void ESP_Mail_Client::clearTLSSessionCache()
+{
+  ESP_MAIL_TLS_SESSION_CACHE::clear();
+}
+#endif
+
 #if defined(ENABLE_SMTP) || defined(ENABLE_IMAP)
 
 void ESP_Mail_Client::setTimezone(const char *TZ_Var, const char *TZ_file)
@@ -362,32 +374,57 @@ void ESP_Mail_Client::strcat_c(char *str, char c)
 
 int ESP_Mail_Client::strpos(const char *haystack, const char *needle, int offset, bool caseSensitive)
 {
-  if (!haystack || !needle)
+  if (!haystack || !needle || offset < 0)
     return -1;
 
-  int hlen = strlen(haystack);
-  int nlen = strlen(needle);
+  return strpos(haystack, strlen(haystack), needle, strlen(needle), offset, caseSensitive);
+}
 
-  if (hlen == 0 || nlen == 0)
+uint8_t ESP_Mail_Client::foldCase(uint8_t c)
+{
+  // ASCII upper case to lower case without the locale lookup
+  return c + ((uint8_t)(c - 'A') < 26 ? 32 : 0);
+}
+
+int ESP_Mail_Client::strpos(const char *haystack, size_t hlen, const char *needle, size_t nlen, size_t offset, bool caseSensitive)
+{
+  if (!haystack || !needle || nlen == 0 || offset >= hlen || hlen - offset < nlen)
     return -1;
 
-  int hidx = offset, nidx = 0;
-  while ((*(haystack + hidx) != '\0') && (*(needle + nidx) != '\0') && hidx < hlen)
-  {
-    bool nm = caseSensitive ? *(needle + nidx) != *(haystack + hidx) : tolower(*(needle + nidx)) != tolower(*(haystack + hidx));
+  const char *p = haystack + offset;
+  const char *last = haystack + hlen - nlen;
+  uint8_t first = foldCase(needle[0]);
 
-    if (nm)
+  // Use memchr to skip to the candidates when the first byte has no case variant
+  bool scan = caseSensitive || (first < 'a' || first > 'z');
+
+  while (p <= last)
+  {
+    if (scan)
+    {
+      p = (const char *)memchr(p, needle[0], last - p + 1);
+      if (!p)
+        return -1;
+    }
+    else if (foldCase(*p) != first)
     {
-      hidx++;
-      nidx = 0;
+      p++;
+      continue;
     }
+
+    size_t i = 1;
+    if (caseSensitive)
+      i = memcmp(p + 1, needle + 1, nlen - 1) == 0 ? nlen : 0;
     else
     {
-      nidx++;
-      hidx++;
-      if (nidx == nlen)
-        return hidx - nidx;
+      while (i < nlen && foldCase(p[i]) == foldCase(needle[i]))
+        i++;
     }
+
+    if (i == nlen)
+      return p - haystack;
+
+    p++;
   }
 
   return -1;
@@ -542,9 +579,9 @@ size_t ESP_Mail_Client::getReservedLen(size_t len)
   return mbfs->getReservedLen(len);
 }
 
-void *ESP_Mail_Client::newP(size_t len)
+void *ESP_Mail_Client::newP(size_t len, bool clear)
 {
-  return mbfs->newP(len);
+  return mbfs->newP(len, clear);
 }
 
 bool ESP_Mail_Client::strcmpP(const char *buf, int ofs, PGM_P beginH, bool caseSensitive)
@@ -557,19 +594,36 @@ bool ESP_Mail_Client::strcmpP(const char *buf, int ofs, PGM_P beginH, bool caseS
     ofs = p;
   }
 
-  char *tmp2 = (char *)newP(strlen_P(beginH) + 1);
-  memcpy(tmp2, &buf[ofs], strlen_P(beginH));
-  tmp2[strlen_P(beginH)] = 0;
-  MB_String s = beginH;
-  bool ret = (strcasecmp(s.c_str(), tmp2) == 0);
-  delP(&tmp2);
-  return ret;
+  // Compare in place (case insensitive), the comparison stops at the end of buf as the key has no null byte
+  size_t len = strlen_P(beginH);
+  for (size_t i = 0; i < len; i++)
+  {
+    if (foldCase(buf[ofs + i]) != foldCase(pgm_read_byte(beginH + i)))
+      return false;
+  }
+  return true;
 }
 
 int ESP_Mail_Client::strposP(const char *buf, PGM_P beginH, int ofs, bool caseSensitive)
 {
+  if (!buf || !beginH || ofs < 0)
+    return -1;
+
+  size_t nlen = strlen_P(beginH);
+
+#if defined(ESP8266) || defined(__AVR__)
+  // The flash string is not byte addressable, copy the key to stack
+  char key[64];
+  if (nlen < sizeof(key))
+  {
+    memcpy_P(key, beginH, nlen);
+    return strpos(buf, strlen(buf), key, nlen, ofs, caseSensitive);
+  }
   MB_String s = beginH;
-  return strpos(buf, s.c_str(), ofs, caseSensitive);
+  return strpos(buf, strlen(buf), s.c_str(), nlen, ofs, caseSensitive);
+#else
+  return strpos(buf, strlen(buf), beginH, nlen, ofs, caseSensitive);
+#endif
 }
 
 char *ESP_Mail_Client::strP(PGM_P pgm)
@@ -114,6 +114,38 @@ public:
 
   void clear() { _list.clear(); }
 
+  /* Sort the UIDs in ascending order and remove the duplicates */
+  void sort()
+  {
+#if defined(MB_USE_STD_VECTOR)
+    std::sort(_list.begin(), _list.end());
+#else
+    for (size_t i = 1; i < _list.size(); i++)
+    {
+      int uid = _list[i];
+      size_t j = i;
+      for (; j > 0 && _list[j - 1] > uid; j--)
+        _list[j] = _list[j - 1];
+      _list[j] = uid;
+    }
+#endif
+    size_t n = 0;
+    for (size_t i = 0; i < _list.size(); i++)
+    {
+      if (n == 0 || _list[i] != _list[n - 1])
+        _list[n++] = _list[i];
+    }
+#if defined(MB_USE_STD_VECTOR)
+    _list.resize(n);
+#else
+    if (n < _list.size())
+      _list.erase(n, _list.size() - 1);
+#endif
+  }
+
+  /* Get the numbers of UIDs */
+  size_t size() { return _list.size(); }
+
 private:
   MB_VECTOR<int> _list;
 };
@@ -149,6 +181,29 @@ public:
    */
   IMAP_Polling_Status pollingStatus() { return _polling_status; };
 
+  /* Get the numbers of polling status in the order they were received since the folder changed was reported */
+  /**
+   * The consecutive EXISTS are merged into one imap_polling_status_type_new_message status, its messageNum is the last
+   * message number and its argument is the first new message number. The new messages are those numbered from
+   * argument through messageNum.
+   *
+   * The consecutive EXPUNGE are merged into one imap_polling_status_type_remove_message status, its argument
+   * is the list of removed message numbers separated by space and its messageNum is the last one.
+   *
+   * The FETCH of the same message number replaces the argument of the previous imap_polling_status_type_fetch_message status.
+   *
+   * The status of the same watched folder replaces the previous imap_polling_status_type_folder_status status.
+   */
+  size_t pollingStatusCount() { return _polling_events.size(); };
+
+  /* Get the polling status at the specified index */
+  IMAP_Polling_Status pollingStatus(size_t index)
+  {
+    if (index < _polling_events.size())
+      return _polling_events[index];
+    return IMAP_Polling_Status();
+  };
+
   /* Get the predict next message UID */
   size_t nextUID() { return _nextUID; };
 
@@ -181,6 +236,72 @@ private:
     for (size_t i = 0; i < _flags.size(); i++)
       _flags[i].clear();
     _flags.clear();
+    clearPollingStatus();
+  }
+  void clearPollingStatus()
+  {
+    _polling_status.messageNum = 0;
+    _polling_status.type = imap_polling_status_type_undefined;
+    _polling_status.argument.clear();
+    _polling_events.clear();
+  }
+  void addPollingStatus(esp_mail_imap_polling_status_type type, size_t messageNum, const char *argument, const char *folder = "")
+  {
+    IMAP_Polling_Status *last = _polling_events.size() > 0 ? &_polling_events[_polling_events.size() - 1] : nullptr;
+
+    if (type == imap_polling_status_type_new_message && last && last->type == type)
+      last->messageNum = messageNum;
+    else if (type == imap_polling_status_type_remove_message && last && last->type == type)
+    {
+      last->messageNum = messageNum;
+      last->argument += ' ';
+      last->argument += messageNum;
+    }
+    else
+    {
+      last = nullptr;
+
+      if (type == imap_polling_status_type_fetch_message || type == imap_polling_status_type_folder_status)
+      {
+        for (size_t i = 0; i < _polling_events.size(); i++)
+        {
+          if (_polling_events[i].type != type)
+            continue;
+
+          if (type == imap_polling_status_type_fetch_message ? _polling_events[i].messageNum == messageNum : strcmp(_polling_events[i].folder.c_str(), folder) == 0)
+          {
+            last = &_polling_events[i];
+            last->messageNum = messageNum;
+            last->argument = argument;
+            break;
+          }
+        }
+      }
+
+      if (!last)
+      {
+        // drop the oldest status when the queue is full
+        if (_polling_events.size() >= ESP_MAIL_IMAP_POLLING_QUEUE_SIZE)
+        {
+          for (size_t i = 1; i < _polling_events.size(); i++)
+            _polling_events[i - 1] = _polling_events[i];
+          _polling_events.pop_back();
+        }
+
+        IMAP_Polling_Status status;
+        status.type = type;
+        status.messageNum = messageNum;
+        status.folder = folder;
+        if (type == imap_polling_status_type_remove_message)
+          status.argument += messageNum;
+        else
+          status.argument = argument;
+        _polling_events.push_back(status);
+        last = &_polling_events[_polling_events.size() - 1];
+      }
+    }
+
+    _polling_status = *last;
   }
   size_t _msgCount = 0;
   size_t _recentCount = 0;
@@ -192,6 +313,7 @@ private:
   bool _folderChanged = false;
   bool _floderChangedState = false;
   IMAP_Polling_Status _polling_status;
+  MB_VECTOR<IMAP_Polling_Status> _polling_events;
   MB_VECTOR<MB_String> _flags;
 };
 
@@ -255,6 +377,28 @@ typedef void (*imapStatusCallback)(IMAP_Status);
 typedef void (*imapResponseCallback)(IMAP_Response);
 typedef void (*MIMEDataStreamCallback)(MIME_Data_Stream_Info);
 typedef void (*imapCharacterDecodingCallback)(IMAP_Decoding_Info *);
+typedef void (*imapMessageInfoCallback)(IMAP_Message_Info);
+
+/* The class that receives the decoded content of the fetched message parts */
+class MailContentSink
+{
+public:
+  virtual ~MailContentSink() {}
+
+  /* Called before the first data of message part, the part data and data_size are not set */
+  virtual void begin(const MIME_Data_Stream_Info &part) { (void)part; }
+
+  /** Write the data of message part, returns the number of bytes accepted.
+   * Accept less than len to pause, the rest of data will be written again and
+   * no more data is read from server until it was accepted.
+   */
+  virtual size_t write(const uint8_t *data, size_t len) = 0;
+
+  /** Called after the last data of message part or when the part data was not completely written.
+   * The complete is false when the sink timed out or the download failed, the sink should abort its transfer.
+   */
+  virtual void end(bool complete) { (void)complete; }
+};
 
 #endif
 
@@ -273,12 +417,15 @@ public:
     att.blob.data = nullptr;
     att.file.path.clear();
     att.file.storage_type = esp_mail_file_storage_type_none;
+    att.stream.read = NULL;
+    att.stream.size = 0;
     att.descr.name.clear();
     att.descr.filename.clear();
     att.descr.transfer_encoding.clear();
     att.descr.content_encoding.clear();
     att.descr.mime.clear();
     att.descr.content_id.clear();
+    att.descr.cache = false;
     att._int.att_type = esp_mail_att_type_none;
     att._int.index = 0;
     att._int.msg_uid = 0;
@@ -330,6 +477,8 @@ public:
       _att[i].descr.transfer_encoding.clear();
       _att[i].file.path.clear();
       _att[i].file.storage_type = esp_mail_file_storage_type_none;
+      _att[i].stream.read = NULL;
+      _att[i].stream.size = 0;
     }
 
     for (size_t i = 0; i < _parallel.size(); i++)
@@ -342,6 +491,8 @@ public:
       _parallel[i].descr.transfer_encoding.clear();
       _parallel[i].file.path.clear();
       _parallel[i].file.storage_type = esp_mail_file_storage_type_none;
+      _parallel[i].stream.read = NULL;
+      _parallel[i].stream.size = 0;
     }
     _rcp.clear();
     _cc.clear();
@@ -641,7 +792,21 @@ public:
    * @return The boolean value indicates the success of operation.
    */
   template <typename T = const char *>
-  bool setFlag(IMAPSession *imap, int msgUID, T flags, bool closeSession) { return mSetFlag(imap, msgUID, toStringPtr(flags), 0, closeSession); }
+  bool setFlag(IMAPSession *imap, int msgUID, T flags, bool closeSession) { return mSetFlag(imap, msgUID, nullptr, toStringPtr(flags), 0, closeSession); }
+
+  /** Set the argument to the Flags for the messages in the list.
+   *
+   * @param imap The pointer to IMAP session object which holds the data and the
+   * TCP client.
+   * @param toSet The pointer to the MessageList class that contains the list of messages.
+   * @param flags The flag list to set.
+   * @param closeSession The option to close the IMAP session after set flag.
+   * @return The boolean value indicates the success of operation.
+   *
+   * @note The flags are stored with the .SILENT option, the server does not send the updated flags of each message.
+   */
+  template <typename T = const char *>
+  bool setFlag(IMAPSession *imap, MessageList *toSet, T flags, bool closeSession) { return mSetFlag(imap, 0, toSet, toStringPtr(flags), 0, closeSession); }
 
   /** Add the argument to the Flags for the specified message.
    *
@@ -653,7 +818,21 @@ public:
    * @return The boolean value indicates the success of operation.
    */
   template <typename T = const char *>
-  bool addFlag(IMAPSession *imap, int msgUID, T flags, bool closeSession) { return mSetFlag(imap, msgUID, toStringPtr(flags), 1, closeSession); }
+  bool addFlag(IMAPSession *imap, int msgUID, T flags, bool closeSession) { return mSetFlag(imap, msgUID, nullptr, toStringPtr(flags), 1, closeSession); }
+
+  /** Add the argument to the Flags for the messages in the list.
+   *
+   * @param imap The pointer to IMAP session object which holds the data and the
+   * TCP client.
+   * @param toSet The pointer to the MessageList class that contains the list of messages.
+   * @param flags The flag list to add.
+   * @param closeSession The option to close the IMAP session after add flag.
+   * @return The boolean value indicates the success of operation.
+   *
+   * @note The flags are stored with the .SILENT option, the server does not send the updated flags of each message.
+   */
+  template <typename T = const char *>
+  bool addFlag(IMAPSession *imap, MessageList *toSet, T flags, bool closeSession) { return mSetFlag(imap, 0, toSet, toStringPtr(flags), 1, closeSession); }
 
   /** Remove the argument from the Flags for the specified message.
    *
@@ -665,7 +844,30 @@ public:
    * @return The boolean value indicates the success of operation.
    */
   template <typename T = const char *>
-  bool removeFlag(IMAPSession *imap, int msgUID, T flags, bool closeSession) { return mSetFlag(imap, msgUID, toStringPtr(flags), 2, closeSession); }
+  bool removeFlag(IMAPSession *imap, int msgUID, T flags, bool closeSession) { return mSetFlag(imap, msgUID, nullptr, toStringPtr(flags), 2, closeSession); }
+
+  /** Remove the argument from the Flags for the messages in the list.
+   *
+   * @param imap The pointer to IMAP session object which holds the data and the
+   * TCP client.
+   * @param toSet The pointer to the MessageList class that contains the list of messages.
+   * @param flags The flag list to remove.
+   * @param closeSession The option to close the IMAP session after remove flag.
+   * @return The boolean value indicates the success of operation.
+   *
+   * @note The flags are stored with the .SILENT option, the server does not send the updated flags of each message.
+   */
+  template <typename T = const char *>
+  bool removeFlag(IMAPSession *imap, MessageList *toSet, T flags, bool closeSession) { return mSetFlag(imap, 0, toSet, toStringPtr(flags), 2, closeSession); }
+
+  /** Add the single byte character set for decoding the message text and header to UTF-8.
+   *
+   * @param charset The character set name e.g. iso-8859-4.
+   * @param table The Unicode code points of the bytes 0x80 to 0xff (128 entries),
+   * 0 for unmapped byte. The table should remain valid while the messages were read.
+   * @return The boolean value indicates the success of operation.
+   */
+  bool addCharset(const char *charset, const uint16_t *table);
 #endif
 
 #if defined(MBFS_SD_FS) && defined(MBFS_CARD_TYPE_SD)
@@ -736,6 +938,22 @@ public:
    */
   int getFreeHeap();
 
+#if defined(ESP_MAIL_USE_TLS_SESSION_CACHE)
+  /** Get the TLS session cache statistics (ESP32 and ESP8266 only).
+   *
+   * @return The TLS_Session_Cache_Stats that contains the numbers of handshakes,
+   * offered and resumed sessions and the sessions that were evicted from the full cache.
+   * @note The cache hit rate in percent is resumed * 100 / handshakes.
+   */
+  TLS_Session_Cache_Stats getTLSSessionCacheStats();
+
+  /** Remove all cached TLS sessions (ESP32 and ESP8266 only).
+   *
+   * @note The next secure connection to every server will do the full handshake.
+   */
+  void clearTLSSessionCache();
+#endif
+
   /** Get base64 encode string.
    *
    * @return String of base64 encoded string.
@@ -822,8 +1040,14 @@ private:
   // Find string
   int strpos(const char *haystack, const char *needle, int offset, bool caseSensitive = true);
 
+  // Find string with the known lengths
+  int strpos(const char *haystack, size_t hlen, const char *needle, size_t nlen, size_t offset, bool caseSensitive = true);
+
+  // ASCII case folding
+  uint8_t foldCase(uint8_t c);
+
   // Memory allocation
-  void *newP(size_t len);
+  void *newP(size_t len, bool clear = true);
 
   // Memory deallocation
   void delP(void *ptr);
@@ -856,14 +1080,17 @@ private:
 
 #if defined(ENABLE_SMTP)
 
-  // Encode Quoted Printable string
-  void encodeQP(const char *buf, char *out);
+  // Encode Quoted Printable string into the output buffer until it is nearly full, return the output length
+  size_t encodeQP(const char *buf, size_t len, size_t &pos, char *out, size_t outLen, int &col);
 
-  // Add the soft line break to the long text line rfc 3676
-  void formatFlowedText(MB_String &content);
+  // Encode Quoted Printable string and send it chunk by chunk
+  bool sendQP(SMTPSession *smtp, SMTP_Message *msg, MB_String &header, const char *buf, size_t len);
 
-  // Insert soft break
-  void softBreak(MB_String &content, const char *quoteMarks);
+  // Add the soft line break to the long text line rfc 3676, return the output length or count it only when out is NULL
+  size_t formatFlowedText(const char *src, size_t len, char *out);
+
+  // Format the text as flowed text into the output string
+  void formatFlowedText(const MB_String &src, MB_String &out);
 
   // Get content type (MIME) from file extension
   void getMIME(const char *ext, MB_String &mime);
@@ -937,6 +1164,9 @@ private:
   // Send BLOB attachment
   bool sendBlobAttachment(SMTPSession *smtp, SMTP_Message *msg, SMTP_Attachment *att);
 
+  // Send stream attachment
+  bool sendStreamAttachment(SMTPSession *smtp, SMTP_Message *msg, SMTP_Attachment *att);
+
   // Send file content
   bool sendFile(SMTPSession *smtp, SMTP_Message *msg, SMTP_Attachment *att);
 
@@ -992,19 +1222,29 @@ private:
   bool sendFileBody(SMTPSession *smtp, SMTP_Message *msg, uint8_t type);
 
   // Base64 and QP encodings for text and html messages and replace embeded attachment file name with content ID
-  void encodingText(SMTPSession *smtp, SMTP_Message *msg, uint8_t type, MB_String &content);
+  bool encodingText(SMTPSession *smtp, SMTP_Message *msg, uint8_t type, MB_String &content);
  
   // Blob or Stream available
   int chunkAvailable(SMTPSession *smtp, esp_mail_smtp_send_base64_data_info_t &data_info);
 
-  // Read chunk data of blob or file
-  int getChunk(SMTPSession *smtp, esp_mail_smtp_send_base64_data_info_t &data_info, unsigned char *rawChunk, bool base64);
-
   // Terminate chunk reading
   void closeChunk(esp_mail_smtp_send_base64_data_info_t &data_info);
-  
-  // Get base64 encoded buffer or raw buffer
-  void getBuffer(bool base64, uint8_t *out, uint8_t *in, int &encodedCount, int &bufIndex, bool &dataReady, int &size, size_t chunkSize);
+
+  // Read the next chunk of blob or file and encode it as base64 lines (or copy as is) to the send buffer
+  int encodeChunk(esp_mail_smtp_send_base64_data_info_t &data_info, uint8_t *raw, uint8_t *out, bool base64);
+
+#if defined(ESP_MAIL_USE_ATTACHMENT_CACHE)
+  // Get the cache file path and the cache key of blob or opened file
+  void getCacheKey(esp_mail_smtp_send_base64_data_info_t &data_info, MB_String &cacheFile, MB_String &key);
+
+  // Send the cached encoded data, return 1 for success, 0 for cache miss and -1 for sending error
+  int sendCache(SMTPSession *smtp, SMTP_Message *msg, const MB_String &cacheFile, const MB_String &key, uint8_t *buf, size_t bufLen);
+#endif
+
+#if defined(ESP_MAIL_USE_ENCODER_TASK)
+  // The task that encodes the next chunk on the other core while the current chunk is sending
+  static void encoderTask(void *param);
+#endif
 
   // Send blob or file as base64 encoded chunk
   bool sendBase64(SMTPSession *smtp, SMTP_Message *msg, esp_mail_smtp_send_base64_data_info_t &data_info, bool base64, bool report);
@@ -1051,21 +1291,22 @@ private:
   // handle rfc2047 Q (quoted printable) and B (base64) decodings
   RFC2047_Decoder RFC2047Decoder;
 
+  // The user added single byte charsets
+  std::vector<struct esp_mail_charset_transcoder_t> _charsets;
+
   // Check if child part (part number string) is a member of the parent part (part number string)
   // part number string format: <part number>.<sub part number>.<sub part number>
   bool multipartMember(const MB_String &parent, const MB_String &child);
 
-  // Decode string
-  int decodeChar(const char *s);
-
-  // Decode Quoted Printable string
-  void decodeQP_UTF8(const char *buf, char *out);
+  // Decode the content transfer encoding in place, returns the decoded length
+  size_t decodeTransfer(esp_mail_msg_xencoding xencoding, char *buf, size_t len);
 
-  // Actually not decode because 7bit string is enencode string unless prepare valid 7bit string and do qp decoding
-  char *decode7Bit_UTF8(char *buf);
+  // Decode the quoted-printable chunk in place, returns the decoded length.
+  // The pending bytes of previous chunk are prepended, buf should have 2 bytes more than len.
+  size_t decodeQP(struct esp_mail_qp_decoder_t &state, char *buf, size_t len, bool last);
 
-  // Actually not decode because 8bit string is enencode string unless prepare valid 8bit string
-  char *decode8Bit_UTF8(char *buf);
+  // Get the session scratch buffer of at least size bytes for the decoding stages
+  char *decodeScratch(IMAPSession *imap, size_t size);
 
   // Get encoding type from character set string
   esp_mail_char_decoding_scheme getEncodingFromCharset(const char *enc);
@@ -1073,11 +1314,20 @@ private:
   // Decode header field string
   void decodeHeader(IMAPSession *imap, MB_String &headerField);
 
-  // Decode Latin1 to UTF-8
-  int decodeLatin1_UTF8(unsigned char *out, int *outlen, const unsigned char *in, int *inlen);
+  // Convert the decoded bytes of RFC 2047 encoded word to UTF-8
+  static void headerCharsetConv(void *arg, MB_String &out, const char *charset, size_t charsetLen, const char *data, size_t len);
+
+  // Copy the charset name in lower case without separators, returns false if name is too long
+  bool charsetKey(char *key, size_t size, const char *charset, size_t len);
+
+  // Find the single byte charset transcoder, returns -1 if not found
+  int findTranscoder(const char *charset, size_t len);
+
+  // Get the length of leading ASCII bytes
+  size_t asciiLen(const char *in, size_t len);
 
-  // Decode TIS620 to UTF-8
-  void decodeTIS620_UTF8(char *out, const char *in, size_t len);
+  // Transcode the single byte charset to UTF-8, the out buffer should be 3 times of len, returns the output length
+  size_t transcodeUTF8(int transcoder, const char *in, size_t len, char *out);
 
   // Reconnect the network if it disconnected
   bool reconnect(IMAPSession *imap, unsigned long dataTime = 0, bool downloadRequestuest = false);
@@ -1130,8 +1380,8 @@ private:
   // Parse search response
   int parseSearchResponse(IMAPSession *imap, char *buf, int bufLen, int &chunkIdx, PGM_P tag, bool &endSearch, int &nump, const char *key, const char *pc);
 
-  // Parse header state
-  bool parseHeaderState(IMAPSession *imap, const char *buf, PGM_P beginH, bool caseSensitive, struct esp_mail_message_header_t &header, int &headerState, esp_mail_imap_header_state state);
+  // Get the known header field index of header line, the number of known fields for other field or -1 for non-field line
+  int getHeaderField(const char *buf, size_t len, bool caseSensitive);
 
   // Parse header response
   void parseHeaderResponse(IMAPSession *imap, char *buf, int bufLen, int &chunkIdx, struct esp_mail_message_header_t &header, int &headerState, int &octetCount, bool caseSensitive = true);
@@ -1202,8 +1452,17 @@ private:
   // Save header string buffer to file
   void saveHeader(IMAPSession *imap, bool json);
 
-  // Send MIME stream to callback
-  void sendStreamCB(IMAPSession *imap, void *buf, size_t len, int chunkIndex, bool hrdBrk);
+  // Send MIME stream to callback and content sink
+  bool sendStreamCB(IMAPSession *imap, void *buf, size_t len, int chunkIndex);
+
+  // Write all data to content sink, wait while the sink accepts no data until timed out
+  bool writeSink(IMAPSession *imap, const uint8_t *data, size_t len);
+
+  // End the started stream of current part which its last data was not sent e.g. the download failed
+  void endSink(IMAPSession *imap);
+
+  // Report the error of writing the current part data to file or content sink
+  void downloadError(IMAPSession *imap, int err);
 
   // Prepare file path for saving
   void prepareFilePath(IMAPSession *imap, MB_String &filePath, bool header);
@@ -1226,12 +1485,21 @@ private:
   // Parse Idle response
   bool parseIdleResponse(IMAPSession *imap);
 
+  // Parse the untagged response line received while idling
+  void parseIdleLine(IMAPSession *imap, char *buf);
+
+  // Parse the STATUS response of the watched folder
+  bool parseFolderStatusResponse(IMAPSession *imap, char *buf);
+
   // Parse Get UID response
   void parseGetUIDResponse(IMAPSession *imap, char *buf);
 
   // Parse Get Flags response
   void parseGetFlagsResponse(IMAPSession *imap, char *buf);
 
+  // Parse the untagged FETCH response of UID and flags of the message range
+  void parseMessageInfoResponse(IMAPSession *imap, char *buf);
+
   // Parse examine response
   void parseExamineResponse(IMAPSession *imap, char *buf);
 
@@ -1239,7 +1507,7 @@ private:
   bool handleIMAPError(IMAPSession *imap, int err, bool ret);
 
   // Set Flag
-  bool mSetFlag(IMAPSession *imap, int msgUID, MB_StringPtr flags, uint8_t action, bool closeSession);
+  bool mSetFlag(IMAPSession *imap, int msgUID, MessageList *toSet, MB_StringPtr flags, uint8_t action, bool closeSession);
 
 #endif
 };
@@ -1410,6 +1678,33 @@ public:
    */
   const char *getFlags(int msgNum);
 
+  /** Get the UIDs of the messages in the range of message numbers in selected or opened mailbox.
+   *
+   * @param from The first message number in the range.
+   * @param to The last message number in the range or 0 for the last message in the mailbox.
+   * @param callback The callback function that accepts IMAP_Message_Info as parameter.
+   * @return The boolean value which indicates the success of operation.
+   *
+   * @note The UIDs are fetched with a single FETCH command and the callback is called for each message.
+   * No IMAP command should be sent from the callback. The range is limited to the messages in the mailbox,
+   * no command is sent when the mailbox is empty or from is greater than the number of messages.
+   */
+  bool getUIDs(int from, int to, imapMessageInfoCallback callback) { return mGetMessageInfo(from, to, false, callback); }
+
+  /** Get the UIDs and flags of the messages in the range of message numbers in selected or opened mailbox.
+   *
+   * @param from The first message number in the range.
+   * @param to The last message number in the range or 0 for the last message in the mailbox.
+   * @param callback The callback function that accepts IMAP_Message_Info as parameter.
+   * @return The boolean value which indicates the success of operation.
+   *
+   * @note The UIDs and flags are fetched with a single FETCH command and the callback is called for each message.
+   * The flags string is valid only inside the callback. No IMAP command should be sent from the callback.
+   * The range is limited to the messages in the mailbox, no command is sent when the mailbox is empty or
+   * from is greater than the number of messages.
+   */
+  bool getFlags(int from, int to, imapMessageInfoCallback callback) { return mGetMessageInfo(from, to, true, callback); }
+
   /** Send the custom IMAP command and get the result via callback.
    *
    * @param cmd The command string.
@@ -1454,6 +1749,20 @@ public:
   template <typename T = const char *>
   bool copyMessages(MessageList *toCopy, T dest) { return mCopyMessages(toCopy, toStringPtr(dest)); }
 
+  /** Move the messages to the defined mailbox folder.
+   *
+   * @param toMove The pointer to the MessageListList class that contains the
+   * list of messages to move.
+   * @param dest The destination folder that the messages to move to.
+   * @return The boolean value which indicates the success of operation.
+   *
+   * @note The MOVE command is used when the server supports it, otherwise the
+   * messages are copied, flagged as deleted and expunged. Only the moved messages
+   * are expunged when the server supports UIDPLUS.
+   */
+  template <typename T = const char *>
+  bool moveMessages(MessageList *toMove, T dest) { return mMoveMessages(toMove, toStringPtr(dest)); }
+
   /** Delete the messages in the opened mailbox folder.
    *
    * @param toDelete The pointer to the MessageListList class that contains the
@@ -1478,6 +1787,36 @@ public:
    */
   bool folderChanged();
 
+  /** Fetch the messages that were added since the listen was started or the last call of this function.
+   *
+   * @param headerOnly The option to fetch only the message headers, or the headers and the content
+   * as configured by IMAP_Config (enable and download).
+   * @return The boolean value which indicates the success of operation.
+   *
+   * @note The listen is stopped and resumed after fetching when it was started.
+   * The UIDs of new messages are fetched with one UID FETCH <last UID + 1>:* command instead of searching the mailbox.
+   * The result is available from the data function and the callback as readMail.
+   */
+  bool fetchNewSinceIdle(bool headerOnly = true);
+
+  /** Add the mailbox folder to watch for changes while listening to the selected or opened mailbox.
+   *
+   * @param folder The folder name to watch.
+   * @return The boolean value which indicates the success of operation.
+   *
+   * @note The changes of the watched folders are reported as imap_polling_status_type_folder_status
+   * in the polling status of the selected folder info. When the server supports NOTIFY (RFC 5465), the changes
+   * are received on the same connection, otherwise the status of the watched folders is checked
+   * every folder_status_interval (IMAP_Config limit) by pausing the listen.
+   * Should be called before listen.
+   */
+  template <typename T = const char *>
+  bool watchFolder(T folder) { return mWatchFolder(toStringPtr(folder)); }
+
+  /** Remove all the watched mailbox folders.
+   */
+  void clearWatchFolders();
+
   /** Assign the callback function that returns the operating status when
    * fetching or reading the Email.
    *
@@ -1500,6 +1839,13 @@ public:
    */
   void mimeDataStreamCallback(MIMEDataStreamCallback mimeDataStreamCallback);
 
+  /** Assign the sink that receives the decoded content of the fetched message parts.
+   *
+   * @param sink The pointer to MailContentSink object or nullptr to remove.
+   * The sink can pause the reading from server by accepting less data.
+   */
+  void setContentSink(MailContentSink *sink);
+
   /** Determine if no message body contained in the search result and only the
    * message header is available.
    */
@@ -1586,6 +1932,21 @@ private:
   // Stop listen mailbox
   bool mStopListen(bool recon);
 
+  // Add the folder to watch
+  bool mWatchFolder(MB_StringPtr folder);
+
+  // Send NOTIFY SET for the selected and watched folders or NOTIFY NONE when no folder to watch or set is false
+  bool sendNotify(bool set);
+
+  // Append the folder name as the quoted string with the escaped quote and backslash
+  void appendQuotedName(MB_String &cmd, const MB_String &name);
+
+  // Send STATUS of the watched folders when NOTIFY is not supported
+  bool checkWatchFolders();
+
+  // Check whether any watched folder is not the selected folder
+  bool hasOtherWatchFolders();
+
   // Send custom command
   bool mSendCustomCommand(MB_StringPtr cmd, imapResponseCallback callback, MB_StringPtr tag);
 
@@ -1604,6 +1965,22 @@ private:
   // Copy message
   bool mCopyMessages(MessageList *toCopy, MB_StringPtr dest);
 
+  // Move message
+  bool mMoveMessages(MessageList *toMove, MB_StringPtr dest);
+
+  // Get UID and flags of the message range
+  bool mGetMessageInfo(int from, int to, bool flags, imapMessageInfoCallback callback);
+
+  // Select the current folder if it was not selected or readWrite mode is required but was opened in read only mode
+  bool selectCurrentFolder(bool readWrite);
+
+  // Get the UID sequence sets e.g. 100:4099,4200 of the sorted copy of message list, each set is not longer than maxLen
+  void getSequenceSets(MessageList *list, size_t maxLen, MB_VECTOR<MB_String> &sets);
+
+  // Send the UID command to all messages in the list, split at the command length limit and pipelined,
+  // errCode is the error code of the rejected command
+  bool sendSequenceSetCommands(MessageList *list, PGM_P cmd, const MB_String &args, esp_mail_imap_command imapCmd, int errCode);
+
   // Close folder
   bool mCloseFolder(MB_StringPtr folderName);
 
@@ -1629,13 +2006,25 @@ private:
   int _cMsgIdx = 0;
   int _cPartIdx = 0;
   int _totalRead = 0;
+#if defined(ESP_MAIL_USE_IMAP_ARENA)
+  // The memory arena for the strings of _headers, declared first to outlive them
+  MB_Arena _arena{ESP_MAIL_IMAP_ARENA_BLOCK_SIZE};
+#endif
   MB_VECTOR<struct esp_mail_message_header_t> _headers;
+  struct esp_mail_imap_decode_pipeline_t _decodePipeline;
+  char *_decodeScratch = nullptr;
+  size_t _decodeScratchSize = 0;
+  // The line buffer kept while idling, it holds the incomplete line until the rest is received
+  char *_idleBuf = nullptr;
+  int _idleBufLen = 0;
 
   esp_mail_imap_command _imap_cmd = esp_mail_imap_command::esp_mail_imap_cmd_login;
   esp_mail_imap_command _prev_imap_cmd = esp_mail_imap_command::esp_mail_imap_cmd_login;
   esp_mail_imap_command _imap_custom_cmd = esp_mail_imap_cmd_custom;
   esp_mail_imap_command _prev_imap_custom_cmd = esp_mail_imap_cmd_custom;
   bool _idle = false;
+  // The responses of the other pipelined commands follow the tagged response, they are read in the next calls
+  bool _pipelined = false;
   MB_String _cmd;
   MB_VECTOR<struct esp_mail_imap_multipart_level_t> _multipart_levels;
   int _rfc822_part_count = 0;
@@ -1647,6 +2036,16 @@ private:
   MB_String _currentFolder;
   bool _mailboxOpened = false;
   unsigned long _lastSameFolderOpenMillis = 0;
+  // The last UID and message count known when the listen started or new messages were fetched
+  bool _idleTracking = false;
+  uint32_t _idleLastUID = 0;
+  size_t _idleMsgCount = 0;
+  bool _fetchNewMsg = false;
+  MB_VECTOR<struct esp_mail_imap_watch_folder_t> _watchFolders;
+  // NOTIFY was set and the watch list was changed since
+  bool _notifySet = false;
+  bool _watchChanged = false;
+  unsigned long _lastFolderStatusMs = 0;
   MB_String _nextUID;
   MB_String _unseenMsgIndex;
   MB_String _flags_tmp;
@@ -1662,7 +2061,10 @@ private:
   bool _secure = false;
   imapStatusCallback _readCallback = NULL;
   imapResponseCallback _customCmdResCallback = NULL;
+  imapMessageInfoCallback _msgInfoCallback = NULL;
   MIMEDataStreamCallback _mimeDataStreamCallback = NULL;
+  MailContentSink *_contentSink = nullptr;
+  MIME_Data_Stream_Info _streamInfo;
   imapCharacterDecodingCallback _charDecCallback = NULL;
 
   MB_VECTOR<struct esp_mail_imap_msg_num_t> _imap_msg_num;
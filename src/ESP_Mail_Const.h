@@ -32,10 +32,49 @@
 #define ESP_MAIL_CLIENT_TRANSFER_DATA_FAILED 0
 #define ESP_MAIL_CLIENT_STREAM_CHUNK_SIZE 256
 #define ESP_MAIL_CLIENT_RESPONSE_BUFFER_SIZE 1024 // should be 1k or more
+#define ESP_MAIL_CONTENT_SINK_TIMEOUT 10000
+#define ESP_MAIL_IMAP_PIPELINE_DEPTH 8
+#define ESP_MAIL_IMAP_POLLING_QUEUE_SIZE 16
+#define ESP_MAIL_DNS_CACHE_TTL (5 * 60 * 1000)
 #define ESP_MAIL_CLIENT_VALID_TS 1577836800
 
 #endif
 
+#if defined(ENABLE_SMTP) && defined(ESP_MAIL_ENABLE_ATTACHMENT_CACHE) && defined(MBFS_FLASH_FS)
+#define ESP_MAIL_USE_ATTACHMENT_CACHE
+#if !defined(ESP_MAIL_ATTACHMENT_CACHE_DIR)
+#define ESP_MAIL_ATTACHMENT_CACHE_DIR "/mail_cache"
+#endif
+// The maximum length of the cache key line in cache file
+#define ESP_MAIL_ATTACHMENT_CACHE_KEY_LEN 128
+#endif
+
+#if defined(ENABLE_IMAP) && defined(ESP_MAIL_ENABLE_IMAP_ARENA)
+#define ESP_MAIL_USE_IMAP_ARENA
+#if !defined(ESP_MAIL_IMAP_ARENA_BLOCK_SIZE)
+#define ESP_MAIL_IMAP_ARENA_BLOCK_SIZE 2048
+#endif
+#endif
+
+#if (defined(ESP32) || defined(ESP8266)) && !defined(ENABLE_CUSTOM_CLIENT) && !defined(USING_AXTLS) && !defined(ESP_MAIL_DISABLE_TLS_SESSION_CACHE)
+#define ESP_MAIL_USE_TLS_SESSION_CACHE
+#if !defined(ESP_MAIL_TLS_SESSION_CACHE_SIZE)
+#define ESP_MAIL_TLS_SESSION_CACHE_SIZE 2
+#endif
+#if !defined(ESP_MAIL_TLS_SESSION_CACHE_TTL)
+#define ESP_MAIL_TLS_SESSION_CACHE_TTL (60 * 60 * 1000)
+#endif
+#endif
+
+#if defined(ENABLE_SMTP) && defined(ESP32) && !defined(CONFIG_FREERTOS_UNICORE) && !defined(ESP_MAIL_DISABLE_ENCODER_TASK)
+#define ESP_MAIL_USE_ENCODER_TASK
+#define ESP_MAIL_ENCODER_TASK_STACK_SIZE 4096
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#endif
+
 enum esp_mail_file_storage_type
 {
     esp_mail_file_storage_type_none,
@@ -420,6 +459,18 @@ struct esp_mail_attach_file_t
     esp_mail_file_storage_type storage_type = esp_mail_file_storage_type_none;
 };
 
+/* The callback function that reads up to max bytes of attachment data into buf and returns the number of bytes read, 0 for end of data */
+typedef size_t (*AttachmentReadCallback)(uint8_t *buf, size_t max);
+
+struct esp_mail_attach_stream_t
+{
+    /* The callback function to read the attachment data */
+    AttachmentReadCallback read = NULL;
+
+    /* The total data size in byte (optional), 0 for unknown size */
+    size_t size = 0;
+};
+
 struct esp_mail_attach_descr_t
 {
     /* The name of attachment */
@@ -442,6 +493,9 @@ struct esp_mail_attach_descr_t
 
     /* The description of attachment file */
     MB_String description;
+
+    /* Cache the base64 encoded data in flash for the next sending (ESP_MAIL_ENABLE_ATTACHMENT_CACHE required) */
+    bool cache = false;
 };
 
 struct esp_mail_attach_internal_t
@@ -466,6 +520,9 @@ struct esp_mail_attachment_t
     /* The file data config */
     struct esp_mail_attach_file_t file;
 
+    /* The stream data config */
+    struct esp_mail_attach_stream_t stream;
+
     /* reserved for internal usage */
     struct esp_mail_attach_internal_t _int;
 };
@@ -522,11 +579,36 @@ struct esp_mail_smtp_send_base64_data_info_t
     esp_mail_file_storage_type storageType = esp_mail_file_storage_type_none;
     const char *filename = "";
     const uint8_t *rawPtr = nullptr;
+    AttachmentReadCallback stream = NULL;
     bool flashMem = false;
+    bool cache = false;
     size_t size = 0;
     size_t dataIndex = 0;
 };
 
+struct esp_mail_smtp_send_base64_chunk_t
+{
+    /* The index of send buffer that holds this chunk */
+    uint8_t index = 0;
+    /* The encoded length, 0 for end of data and -1 for read error */
+    int len = 0;
+    /* The raw data index after this chunk was read */
+    size_t dataIndex = 0;
+};
+
+#if defined(ESP_MAIL_USE_ENCODER_TASK)
+struct esp_mail_smtp_encoder_task_t
+{
+    esp_mail_smtp_send_base64_data_info_t *data_info = nullptr;
+    uint8_t *buf[2] = {nullptr, nullptr};
+    uint8_t *raw = nullptr;
+    bool base64 = false;
+    QueueHandle_t freeQueue = NULL;
+    QueueHandle_t readyQueue = NULL;
+    SemaphoreHandle_t done = NULL;
+};
+#endif
+
 enum esp_mail_smtp_command
 {
     esp_mail_smtp_cmd_undefined,
@@ -614,7 +696,8 @@ enum esp_mail_imap_polling_status_type
     imap_polling_status_type_undefined,
     imap_polling_status_type_new_message,
     imap_polling_status_type_remove_message,
-    imap_polling_status_type_fetch_message
+    imap_polling_status_type_fetch_message,
+    imap_polling_status_type_folder_status
 };
 
 enum esp_mail_imap_header_state
@@ -667,6 +750,7 @@ enum esp_mail_imap_command
     esp_mail_imap_cmd_done,
     esp_mail_imap_cmd_get_uid,
     esp_mail_imap_cmd_get_flags,
+    esp_mail_imap_cmd_get_msg_info,
     esp_mail_imap_cmd_append,
     esp_mail_imap_cmd_append_last,
     esp_mail_imap_cmd_custom
@@ -754,6 +838,10 @@ struct esp_mail_imap_capability_t
     bool uidplus = false;
     bool acl = false;
     bool binary = false;
+    // rfc6851
+    bool move = false;
+    // rfc5465
+    bool notify = false;
 };
 
 struct esp_mail_imap_rfc822_msg_header_item_t
@@ -1041,19 +1129,46 @@ struct esp_mail_imap_content_disposition_type_t
 typedef struct esp_mail_imap_polling_status_t
 {
     /** The type of status e.g. imap_polling_status_type_undefined, imap_polling_status_type_new_message,
-     * imap_polling_status_type_fetch_message and imap_polling_status_type_remove_message.
+     * imap_polling_status_type_fetch_message, imap_polling_status_type_remove_message and
+     * imap_polling_status_type_folder_status.
      */
     esp_mail_imap_polling_status_type type = imap_polling_status_type_undefined;
 
     /** Message number or order from the total number of message that added, fetched or deleted.
+     * The total number of messages in the folder for imap_polling_status_type_folder_status.
      */
     size_t messageNum = 0;
 
-    /** Argument of commands e.g. FETCH
+    /** Argument of commands e.g. FETCH, or the status items e.g. MESSAGES 12 UIDNEXT 345
      */
     MB_String argument;
+
+    /** The watched folder name for imap_polling_status_type_folder_status
+     */
+    MB_String folder;
 } IMAP_Polling_Status;
 
+struct esp_mail_imap_watch_folder_t
+{
+    MB_String name;
+    size_t msgCount = 0;
+    uint32_t nextUID = 0;
+    /* the status was received once */
+    bool init = false;
+};
+
+typedef struct esp_mail_imap_msg_info_t
+{
+    /* message number */
+    int msgNum = 0;
+
+    /* message UID */
+    uint32_t uid = 0;
+
+    /* message flags e.g. \Seen \Answered, empty when flags were not fetched */
+    const char *flags = "";
+} IMAP_Message_Info;
+
 struct esp_mail_message_part_info_t
 {
     enum content_header_field
@@ -1079,6 +1194,9 @@ struct esp_mail_message_part_info_t
     uint32_t stringPtr = 0;
     esp_mail_char_decoding_scheme stringEnc = esp_mail_char_decoding_scheme_default;
 
+    // The charset transcoder of the text content, -2 for unresolved and -1 for none.
+    int transcoder = -2;
+
     content_header_field cur_content_hdr = content_header_field_none;
 
     MB_String partNumStr;
@@ -1111,6 +1229,36 @@ struct esp_mail_message_part_info_t
     bool plain_flowed = false;
     bool plain_delsp = false;
     esp_mail_msg_xencoding xencoding = esp_mail_msg_xencoding_none;
+    // The content stream state, 0 for not started, 1 for started and 2 for ended.
+    int stream_state = 0;
+    // The content sink did not accept the data in time, the rest of data is not written.
+    bool sink_error = false;
+};
+
+/* The quoted-printable decoder state kept across the read chunks */
+struct esp_mail_qp_decoder_t
+{
+    /* The bytes of the incomplete escape sequence at the end of previous chunk */
+    char pending[2];
+    uint8_t pendingLen = 0;
+};
+
+/* The decoding stages of the message text part, built once per part */
+struct esp_mail_imap_decode_pipeline_t
+{
+    /* The part content is stored, downloaded or streamed */
+    bool enable = false;
+    /* The part content download was configured */
+    bool download = false;
+    /* The transfer decoding stage (in place) */
+    esp_mail_msg_xencoding xencoding = esp_mail_msg_xencoding_none;
+    struct esp_mail_qp_decoder_t qp;
+    /* The charset stage, by user callback or by transcoder (-1 for none) */
+    bool charDecCallback = false;
+    int transcoder = -1;
+    /* The output stages */
+    bool toText = false;
+    bool toFile = false;
 };
 
 struct esp_mail_message_header_t
@@ -1209,6 +1357,11 @@ struct esp_mail_imap_enable_config_t
 
     /* To allow case sesitive in header parsing */
     bool header_case_sensitive = false;
+
+    /** To check the connection by restarting the idle (DONE and IDLE) instead of
+     * the host name resolution at every imap_idle_host_check_interval
+     */
+    bool idle_probe = false;
 };
 
 struct esp_mail_imap_limit_config_t
@@ -1232,6 +1385,17 @@ struct esp_mail_imap_limit_config_t
      * Default is 1 min.
      */
     size_t imap_idle_host_check_interval = 60 * 1000;
+
+    /** The maximum length of the command line with the message sequence set.
+     * The longer command is split into the pipelined commands.
+     * Default is 1000 bytes.
+     */
+    size_t cmd_size = 1000;
+
+    /** The interval in ms (10 sec to imap_idle_timeout) to check the status of the watched folders
+     * when the server does not support NOTIFY. Default is 1 min.
+     */
+    size_t folder_status_interval = 60 * 1000;
 };
 
 struct esp_mail_imap_storage_config_t
@@ -1913,6 +2077,9 @@ static const char esp_mail_imap_response_23[] PROGMEM = "MULTIAPPEND";
 static const char esp_mail_imap_response_24[] PROGMEM = "UIDPLUS";
 static const char esp_mail_imap_response_25[] PROGMEM = "LITERAL+";
 static const char esp_mail_imap_response_26[] PROGMEM = "LITERAL-";
+static const char esp_mail_imap_response_27[] PROGMEM = "MOVE"; // rfc6851
+static const char esp_mail_imap_response_28[] PROGMEM = "NOTIFY"; // rfc5465
+static const char esp_mail_imap_response_29[] PROGMEM = "* STATUS ";
 
 #endif
 
@@ -1991,6 +2158,383 @@ static const char esp_mail_str_362[] PROGMEM = "> C: apend message";
 static const char esp_mail_str_363[] PROGMEM = "Message append successfully";
 static const char esp_mail_str_364[] PROGMEM = "> c: Message append successfully";
 static const char esp_mail_str_365[] PROGMEM = "binary";
+static const char esp_mail_str_366[] PROGMEM = "> C: move message(s) to ";
+static const char esp_mail_str_367[] PROGMEM = "UID MOVE ";
+static const char esp_mail_str_368[] PROGMEM = "UID EXPUNGE ";
+static const char esp_mail_str_369[] PROGMEM = " (UID FLAGS)";
+static const char esp_mail_str_370[] PROGMEM = " FETCH (";
+static const char esp_mail_str_371[] PROGMEM = "FLAGS (";
+static const char esp_mail_str_372[] PROGMEM = "Get UIDs...";
+static const char esp_mail_str_373[] PROGMEM = "> C: Get UIDs...";
+static const char esp_mail_str_374[] PROGMEM = " FLAGS.SILENT (";
+static const char esp_mail_str_375[] PROGMEM = " +FLAGS.SILENT (";
+static const char esp_mail_str_376[] PROGMEM = " -FLAGS.SILENT (";
+static const char esp_mail_str_377[] PROGMEM = "Fetch new messages...";
+static const char esp_mail_str_378[] PROGMEM = "> C: Fetch new messages...";
+static const char esp_mail_str_379[] PROGMEM = "NOTIFY SET STATUS (selected (MessageNew MessageExpunge FlagChange)) (mailboxes (";
+static const char esp_mail_str_380[] PROGMEM = ") (MessageNew MessageExpunge))";
+static const char esp_mail_str_381[] PROGMEM = "NOTIFY NONE";
+static const char esp_mail_str_382[] PROGMEM = "STATUS ";
+static const char esp_mail_str_383[] PROGMEM = " (MESSAGES UIDNEXT UNSEEN)";
+static const char esp_mail_str_384[] PROGMEM = "MESSAGES ";
+static const char esp_mail_str_385[] PROGMEM = "UIDNEXT ";
+static const char esp_mail_str_386[] PROGMEM = "> C: Check the watched folders status";
+static const char esp_mail_str_387[] PROGMEM = "content sink write timed out";
+#endif
+
+#if defined(ENABLE_IMAP)
+
+struct esp_mail_imap_header_field_t
+{
+    /* The field name with colon */
+    PGM_P name;
+    esp_mail_imap_header_state state;
+};
+
+/* The message header fields to parse */
+static const struct esp_mail_imap_header_field_t esp_mail_imap_header_fields[] = {
+    {esp_mail_str_10, esp_mail_imap_state_from},
+    {esp_mail_str_150, esp_mail_imap_state_sender},
+    {esp_mail_str_11, esp_mail_imap_state_to},
+    {esp_mail_str_12, esp_mail_imap_state_cc},
+    {esp_mail_str_24, esp_mail_imap_state_subject},
+    {esp_mail_str_46, esp_mail_imap_state_return_path},
+    {esp_mail_str_184, esp_mail_imap_state_reply_to},
+    {esp_mail_str_109, esp_mail_imap_state_in_reply_to},
+    {esp_mail_str_107, esp_mail_imap_state_references},
+    {esp_mail_str_134, esp_mail_imap_state_comments},
+    {esp_mail_str_145, esp_mail_imap_state_keywords},
+    {esp_mail_str_172, esp_mail_imap_state_content_transfer_encoding},
+    {esp_mail_str_190, esp_mail_imap_state_accept_language},
+    {esp_mail_str_191, esp_mail_imap_state_content_language},
+    {esp_mail_str_99, esp_mail_imap_state_date},
+    {esp_mail_str_101, esp_mail_imap_state_msg_id},
+    {esp_mail_str_25, esp_mail_imap_state_content_type}};
+
+/**
+ * The perfect hash slots of esp_mail_imap_header_fields (index + 1, 0 for no field).
+ * The slot of the field name (without colon) of length len is
+ * (len * 10 + lower(first char) * 25 + lower(last char)) & 31.
+ * Regenerate these slots when the field list was changed.
+ */
+static const uint8_t esp_mail_imap_header_field_slots[32] = {0, 7, 4, 0, 0, 0, 0, 0, 17, 2, 0, 1, 12, 16, 10, 0, 14, 15, 0, 0, 13, 5, 11, 3, 6, 9, 0, 0, 0, 0, 8, 0};
+
+/* The Unicode code points of the bytes 0x80 - 0xff of the single byte charsets, 0 for unmapped byte */
+static const uint16_t esp_mail_charset_windows_1250[128] PROGMEM = {
+    0x20AC, 0x0000, 0x201A, 0x0000, 0x201E, 0x2026, 0x2020, 0x2021,
+    0x0000, 0x2030, 0x0160, 0x2039, 0x015A, 0x0164, 0x017D, 0x0179,
+    0x0000, 0x2018, 0x2019, 0x201C, 0x201D, 0x2022, 0x2013, 0x2014,
+    0x0000, 0x2122, 0x0161, 0x203A, 0x015B, 0x0165, 0x017E, 0x017A,
+    0x00A0, 0x02C7, 0x02D8, 0x0141, 0x00A4, 0x0104, 0x00A6, 0x00A7,
+    0x00A8, 0x00A9, 0x015E, 0x00AB, 0x00AC, 0x00AD, 0x00AE, 0x017B,
+    0x00B0, 0x00B1, 0x02DB, 0x0142, 0x00B4, 0x00B5, 0x00B6, 0x00B7,
+    0x00B8, 0x0105, 0x015F, 0x00BB, 0x013D, 0x02DD, 0x013E, 0x017C,
+    0x0154, 0x00C1, 0x00C2, 0x0102, 0x00C4, 0x0139, 0x0106, 0x00C7,
+    0x010C, 0x00C9, 0x0118, 0x00CB, 0x011A, 0x00CD, 0x00CE, 0x010E,
+    0x0110, 0x0143, 0x0147, 0x00D3, 0x00D4, 0x0150, 0x00D6, 0x00D7,
+    0x0158, 0x016E, 0x00DA, 0x0170, 0x00DC, 0x00DD, 0x0162, 0x00DF,
+    0x0155, 0x00E1, 0x00E2, 0x0103, 0x00E4, 0x013A, 0x0107, 0x00E7,
+    0x010D, 0x00E9, 0x0119, 0x00EB, 0x011B, 0x00ED, 0x00EE, 0x010F,
+    0x0111, 0x0144, 0x0148, 0x00F3, 0x00F4, 0x0151, 0x00F6, 0x00F7,
+    0x0159, 0x016F, 0x00FA, 0x0171, 0x00FC, 0x00FD, 0x0163, 0x02D9};
+
+static const uint16_t esp_mail_charset_windows_1251[128] PROGMEM = {
+    0x0402, 0x0403, 0x201A, 0x0453, 0x201E, 0x2026, 0x2020, 0x2021,
+    0x20AC, 0x2030, 0x0409, 0x2039, 0x040A, 0x040C, 0x040B, 0x040F,
+    0x0452, 0x2018, 0x2019, 0x201C, 0x201D, 0x2022, 0x2013, 0x2014,
+    0x0000, 0x2122, 0x0459, 0x203A, 0x045A, 0x045C, 0x045B, 0x045F,
+    0x00A0, 0x040E, 0x045E, 0x0408, 0x00A4, 0x0490, 0x00A6, 0x00A7,
+    0x0401, 0x00A9, 0x0404, 0x00AB, 0x00AC, 0x00AD, 0x00AE, 0x0407,
+    0x00B0, 0x00B1, 0x0406, 0x0456, 0x0491, 0x00B5, 0x00B6, 0x00B7,
+    0x0451, 0x2116, 0x0454, 0x00BB, 0x0458, 0x0405, 0x0455, 0x0457,
+    0x0410, 0x0411, 0x0412, 0x0413, 0x0414, 0x0415, 0x0416, 0x0417,
+    0x0418, 0x0419, 0x041A, 0x041B, 0x041C, 0x041D, 0x041E, 0x041F,
+    0x0420, 0x0421, 0x0422, 0x0423, 0x0424, 0x0425, 0x0426, 0x0427,
+    0x0428, 0x0429, 0x042A, 0x042B, 0x042C, 0x042D, 0x042E, 0x042F,
+    0x0430, 0x0431, 0x0432, 0x0433, 0x0434, 0x0435, 0x0436, 0x0437,
+    0x0438, 0x0439, 0x043A, 0x043B, 0x043C, 0x043D, 0x043E, 0x043F,
+    0x0440, 0x0441, 0x0442, 0x0443, 0x0444, 0x0445, 0x0446, 0x0447,
+    0x0448, 0x0449, 0x044A, 0x044B, 0x044C, 0x044D, 0x044E, 0x044F};
+
+static const uint16_t esp_mail_charset_windows_1252[128] PROGMEM = {
+    0x20AC, 0x0000, 0x201A, 0x0192, 0x201E, 0x2026, 0x2020, 0x2021,
+    0x02C6, 0x2030, 0x0160, 0x2039, 0x0152, 0x0000, 0x017D, 0x0000,
+    0x0000, 0x2018, 0x2019, 0x201C, 0x201D, 0x2022, 0x2013, 0x2014,
+    0x02DC, 0x2122, 0x0161, 0x203A, 0x0153, 0x0000, 0x017E, 0x0178,
+    0x00A0, 0x00A1, 0x00A2, 0x00A3, 0x00A4, 0x00A5, 0x00A6, 0x00A7,
+    0x00A8, 0x00A9, 0x00AA, 0x00AB, 0x00AC, 0x00AD, 0x00AE, 0x00AF,
+    0x00B0, 0x00B1, 0x00B2, 0x00B3, 0x00B4, 0x00B5, 0x00B6, 0x00B7,
+    0x00B8, 0x00B9, 0x00BA, 0x00BB, 0x00BC, 0x00BD, 0x00BE, 0x00BF,
+    0x00C0, 0x00C1, 0x00C2, 0x00C3, 0x00C4, 0x00C5, 0x00C6, 0x00C7,
+    0x00C8, 0x00C9, 0x00CA, 0x00CB, 0x00CC, 0x00CD, 0x00CE, 0x00CF,
+    0x00D0, 0x00D1, 0x00D2, 0x00D3, 0x00D4, 0x00D5, 0x00D6, 0x00D7,
+    0x00D8, 0x00D9, 0x00DA, 0x00DB, 0x00DC, 0x00DD, 0x00DE, 0x00DF,
+    0x00E0, 0x00E1, 0x00E2, 0x00E3, 0x00E4, 0x00E5, 0x00E6, 0x00E7,
+    0x00E8, 0x00E9, 0x00EA, 0x00EB, 0x00EC, 0x00ED, 0x00EE, 0x00EF,
+    0x00F0, 0x00F1, 0x00F2, 0x00F3, 0x00F4, 0x00F5, 0x00F6, 0x00F7,
+    0x00F8, 0x00F9, 0x00FA, 0x00FB, 0x00FC, 0x00FD, 0x00FE, 0x00FF};
+
+static const uint16_t esp_mail_charset_windows_1253[128] PROGMEM = {
+    0x20AC, 0x0000, 0x201A, 0x0192, 0x201E, 0x2026, 0x2020, 0x2021,
+    0x0000, 0x2030, 0x0000, 0x2039, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x2018, 0x2019, 0x201C, 0x201D, 0x2022, 0x2013, 0x2014,
+    0x0000, 0x2122, 0x0000, 0x203A, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x00A0, 0x0385, 0x0386, 0x00A3, 0x00A4, 0x00A5, 0x00A6, 0x00A7,
+    0x00A8, 0x00A9, 0x0000, 0x00AB, 0x00AC, 0x00AD, 0x00AE, 0x2015,
+    0x00B0, 0x00B1, 0x00B2, 0x00B3, 0x0384, 0x00B5, 0x00B6, 0x00B7,
+    0x0388, 0x0389, 0x038A, 0x00BB, 0x038C, 0x00BD, 0x038E, 0x038F,
+    0x0390, 0x0391, 0x0392, 0x0393, 0x0394, 0x0395, 0x0396, 0x0397,
+    0x0398, 0x0399, 0x039A, 0x039B, 0x039C, 0x039D, 0x039E, 0x039F,
+    0x03A0, 0x03A1, 0x0000, 0x03A3, 0x03A4, 0x03A5, 0x03A6, 0x03A7,
+    0x03A8, 0x03A9, 0x03AA, 0x03AB, 0x03AC, 0x03AD, 0x03AE, 0x03AF,
+    0x03B0, 0x03B1, 0x03B2, 0x03B3, 0x03B4, 0x03B5, 0x03B6, 0x03B7,
+    0x03B8, 0x03B9, 0x03BA, 0x03BB, 0x03BC, 0x03BD, 0x03BE, 0x03BF,
+    0x03C0, 0x03C1, 0x03C2, 0x03C3, 0x03C4, 0x03C5, 0x03C6, 0x03C7,
+    0x03C8, 0x03C9, 0x03CA, 0x03CB, 0x03CC, 0x03CD, 0x03CE, 0x0000};
+
+static const uint16_t esp_mail_charset_windows_1254[128] PROGMEM = {
+    0x20AC, 0x0000, 0x201A, 0x0192, 0x201E, 0x2026, 0x2020, 0x2021,
+    0x02C6, 0x2030, 0x0160, 0x2039, 0x0152, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x2018, 0x2019, 0x201C, 0x201D, 0x2022, 0x2013, 0x2014,
+    0x02DC, 0x2122, 0x0161, 0x203A, 0x0153, 0x0000, 0x0000, 0x0178,
+    0x00A0, 0x00A1, 0x00A2, 0x00A3, 0x00A4, 0x00A5, 0x00A6, 0x00A7,
+    0x00A8, 0x00A9, 0x00AA, 0x00AB, 0x00AC, 0x00AD, 0x00AE, 0x00AF,
+    0x00B0, 0x00B1, 0x00B2, 0x00B3, 0x00B4, 0x00B5, 0x00B6, 0x00B7,
+    0x00B8, 0x00B9, 0x00BA, 0x00BB, 0x00BC, 0x00BD, 0x00BE, 0x00BF,
+    0x00C0, 0x00C1, 0x00C2, 0x00C3, 0x00C4, 0x00C5, 0x00C6, 0x00C7,
+    0x00C8, 0x00C9, 0x00CA, 0x00CB, 0x00CC, 0x00CD, 0x00CE, 0x00CF,
+    0x011E, 0x00D1, 0x00D2, 0x00D3, 0x00D4, 0x00D5, 0x00D6, 0x00D7,
+    0x00D8, 0x00D9, 0x00DA, 0x00DB, 0x00DC, 0x0130, 0x015E, 0x00DF,
+    0x00E0, 0x00E1, 0x00E2, 0x00E3, 0x00E4, 0x00E5, 0x00E6, 0x00E7,
+    0x00E8, 0x00E9, 0x00EA, 0x00EB, 0x00EC, 0x00ED, 0x00EE, 0x00EF,
+    0x011F, 0x00F1, 0x00F2, 0x00F3, 0x00F4, 0x00F5, 0x00F6, 0x00F7,
+    0x00F8, 0x00F9, 0x00FA, 0x00FB, 0x00FC, 0x0131, 0x015F, 0x00FF};
+
+static const uint16_t esp_mail_charset_windows_1257[128] PROGMEM = {
+    0x20AC, 0x0000, 0x201A, 0x0000, 0x201E, 0x2026, 0x2020, 0x2021,
+    0x0000, 0x2030, 0x0000, 0x2039, 0x0000, 0x00A8, 0x02C7, 0x00B8,
+    0x0000, 0x2018, 0x2019, 0x201C, 0x201D, 0x2022, 0x2013, 0x2014,
+    0x0000, 0x2122, 0x0000, 0x203A, 0x0000, 0x00AF, 0x02DB, 0x0000,
+    0x00A0, 0x0000, 0x00A2, 0x00A3, 0x00A4, 0x0000, 0x00A6, 0x00A7,
+    0x00D8, 0x00A9, 0x0156, 0x00AB, 0x00AC, 0x00AD, 0x00AE, 0x00C6,
+    0x00B0, 0x00B1, 0x00B2, 0x00B3, 0x00B4, 0x00B5, 0x00B6, 0x00B7,
+    0x00F8, 0x00B9, 0x0157, 0x00BB, 0x00BC, 0x00BD, 0x00BE, 0x00E6,
+    0x0104, 0x012E, 0x0100, 0x0106, 0x00C4, 0x00C5, 0x0118, 0x0112,
+    0x010C, 0x00C9, 0x0179, 0x0116, 0x0122, 0x0136, 0x012A, 0x013B,
+    0x0160, 0x0143, 0x0145, 0x00D3, 0x014C, 0x00D5, 0x00D6, 0x00D7,
+    0x0172, 0x0141, 0x015A, 0x016A, 0x00DC, 0x017B, 0x017D, 0x00DF,
+    0x0105, 0x012F, 0x0101, 0x0107, 0x00E4, 0x00E5, 0x0119, 0x0113,
+    0x010D, 0x00E9, 0x017A, 0x0117, 0x0123, 0x0137, 0x012B, 0x013C,
+    0x0161, 0x0144, 0x0146, 0x00F3, 0x014D, 0x00F5, 0x00F6, 0x00F7,
+    0x0173, 0x0142, 0x015B, 0x016B, 0x00FC, 0x017C, 0x017E, 0x02D9};
+
+static const uint16_t esp_mail_charset_windows_874[128] PROGMEM = {
+    0x20AC, 0x0000, 0x0000, 0x0000, 0x0000, 0x2026, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x2018, 0x2019, 0x201C, 0x201D, 0x2022, 0x2013, 0x2014,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x00A0, 0x0E01, 0x0E02, 0x0E03, 0x0E04, 0x0E05, 0x0E06, 0x0E07,
+    0x0E08, 0x0E09, 0x0E0A, 0x0E0B, 0x0E0C, 0x0E0D, 0x0E0E, 0x0E0F,
+    0x0E10, 0x0E11, 0x0E12, 0x0E13, 0x0E14, 0x0E15, 0x0E16, 0x0E17,
+    0x0E18, 0x0E19, 0x0E1A, 0x0E1B, 0x0E1C, 0x0E1D, 0x0E1E, 0x0E1F,
+    0x0E20, 0x0E21, 0x0E22, 0x0E23, 0x0E24, 0x0E25, 0x0E26, 0x0E27,
+    0x0E28, 0x0E29, 0x0E2A, 0x0E2B, 0x0E2C, 0x0E2D, 0x0E2E, 0x0E2F,
+    0x0E30, 0x0E31, 0x0E32, 0x0E33, 0x0E34, 0x0E35, 0x0E36, 0x0E37,
+    0x0E38, 0x0E39, 0x0E3A, 0x0000, 0x0000, 0x0000, 0x0000, 0x0E3F,
+    0x0E40, 0x0E41, 0x0E42, 0x0E43, 0x0E44, 0x0E45, 0x0E46, 0x0E47,
+    0x0E48, 0x0E49, 0x0E4A, 0x0E4B, 0x0E4C, 0x0E4D, 0x0E4E, 0x0E4F,
+    0x0E50, 0x0E51, 0x0E52, 0x0E53, 0x0E54, 0x0E55, 0x0E56, 0x0E57,
+    0x0E58, 0x0E59, 0x0E5A, 0x0E5B, 0x0000, 0x0000, 0x0000, 0x0000};
+
+static const uint16_t esp_mail_charset_iso8859_2[128] PROGMEM = {
+    0x0080, 0x0081, 0x0082, 0x0083, 0x0084, 0x0085, 0x0086, 0x0087,
+    0x0088, 0x0089, 0x008A, 0x008B, 0x008C, 0x008D, 0x008E, 0x008F,
+    0x0090, 0x0091, 0x0092, 0x0093, 0x0094, 0x0095, 0x0096, 0x0097,
+    0x0098, 0x0099, 0x009A, 0x009B, 0x009C, 0x009D, 0x009E, 0x009F,
+    0x00A0, 0x0104, 0x02D8, 0x0141, 0x00A4, 0x013D, 0x015A, 0x00A7,
+    0x00A8, 0x0160, 0x015E, 0x0164, 0x0179, 0x00AD, 0x017D, 0x017B,
+    0x00B0, 0x0105, 0x02DB, 0x0142, 0x00B4, 0x013E, 0x015B, 0x02C7,
+    0x00B8, 0x0161, 0x015F, 0x0165, 0x017A, 0x02DD, 0x017E, 0x017C,
+    0x0154, 0x00C1, 0x00C2, 0x0102, 0x00C4, 0x0139, 0x0106, 0x00C7,
+    0x010C, 0x00C9, 0x0118, 0x00CB, 0x011A, 0x00CD, 0x00CE, 0x010E,
+    0x0110, 0x0143, 0x0147, 0x00D3, 0x00D4, 0x0150, 0x00D6, 0x00D7,
+    0x0158, 0x016E, 0x00DA, 0x0170, 0x00DC, 0x00DD, 0x0162, 0x00DF,
+    0x0155, 0x00E1, 0x00E2, 0x0103, 0x00E4, 0x013A, 0x0107, 0x00E7,
+    0x010D, 0x00E9, 0x0119, 0x00EB, 0x011B, 0x00ED, 0x00EE, 0x010F,
+    0x0111, 0x0144, 0x0148, 0x00F3, 0x00F4, 0x0151, 0x00F6, 0x00F7,
+    0x0159, 0x016F, 0x00FA, 0x0171, 0x00FC, 0x00FD, 0x0163, 0x02D9};
+
+static const uint16_t esp_mail_charset_iso8859_5[128] PROGMEM = {
+    0x0080, 0x0081, 0x0082, 0x0083, 0x0084, 0x0085, 0x0086, 0x0087,
+    0x0088, 0x0089, 0x008A, 0x008B, 0x008C, 0x008D, 0x008E, 0x008F,
+    0x0090, 0x0091, 0x0092, 0x0093, 0x0094, 0x0095, 0x0096, 0x0097,
+    0x0098, 0x0099, 0x009A, 0x009B, 0x009C, 0x009D, 0x009E, 0x009F,
+    0x00A0, 0x0401, 0x0402, 0x0403, 0x0404, 0x0405, 0x0406, 0x0407,
+    0x0408, 0x0409, 0x040A, 0x040B, 0x040C, 0x00AD, 0x040E, 0x040F,
+    0x0410, 0x0411, 0x0412, 0x0413, 0x0414, 0x0415, 0x0416, 0x0417,
+    0x0418, 0x0419, 0x041A, 0x041B, 0x041C, 0x041D, 0x041E, 0x041F,
+    0x0420, 0x0421, 0x0422, 0x0423, 0x0424, 0x0425, 0x0426, 0x0427,
+    0x0428, 0x0429, 0x042A, 0x042B, 0x042C, 0x042D, 0x042E, 0x042F,
+    0x0430, 0x0431, 0x0432, 0x0433, 0x0434, 0x0435, 0x0436, 0x0437,
+    0x0438, 0x0439, 0x043A, 0x043B, 0x043C, 0x043D, 0x043E, 0x043F,
+    0x0440, 0x0441, 0x0442, 0x0443, 0x0444, 0x0445, 0x0446, 0x0447,
+    0x0448, 0x0449, 0x044A, 0x044B, 0x044C, 0x044D, 0x044E, 0x044F,
+    0x2116, 0x0451, 0x0452, 0x0453, 0x0454, 0x0455, 0x0456, 0x0457,
+    0x0458, 0x0459, 0x045A, 0x045B, 0x045C, 0x00A7, 0x045E, 0x045F};
+
+static const uint16_t esp_mail_charset_iso8859_7[128] PROGMEM = {
+    0x0080, 0x0081, 0x0082, 0x0083, 0x0084, 0x0085, 0x0086, 0x0087,
+    0x0088, 0x0089, 0x008A, 0x008B, 0x008C, 0x008D, 0x008E, 0x008F,
+    0x0090, 0x0091, 0x0092, 0x0093, 0x0094, 0x0095, 0x0096, 0x0097,
+    0x0098, 0x0099, 0x009A, 0x009B, 0x009C, 0x009D, 0x009E, 0x009F,
+    0x00A0, 0x2018, 0x2019, 0x00A3, 0x20AC, 0x20AF, 0x00A6, 0x00A7,
+    0x00A8, 0x00A9, 0x037A, 0x00AB, 0x00AC, 0x00AD, 0x0000, 0x2015,
+    0x00B0, 0x00B1, 0x00B2, 0x00B3, 0x0384, 0x0385, 0x0386, 0x00B7,
+    0x0388, 0x0389, 0x038A, 0x00BB, 0x038C, 0x00BD, 0x038E, 0x038F,
+    0x0390, 0x0391, 0x0392, 0x0393, 0x0394, 0x0395, 0x0396, 0x0397,
+    0x0398, 0x0399, 0x039A, 0x039B, 0x039C, 0x039D, 0x039E, 0x039F,
+    0x03A0, 0x03A1, 0x0000, 0x03A3, 0x03A4, 0x03A5, 0x03A6, 0x03A7,
+    0x03A8, 0x03A9, 0x03AA, 0x03AB, 0x03AC, 0x03AD, 0x03AE, 0x03AF,
+    0x03B0, 0x03B1, 0x03B2, 0x03B3, 0x03B4, 0x03B5, 0x03B6, 0x03B7,
+    0x03B8, 0x03B9, 0x03BA, 0x03BB, 0x03BC, 0x03BD, 0x03BE, 0x03BF,
+    0x03C0, 0x03C1, 0x03C2, 0x03C3, 0x03C4, 0x03C5, 0x03C6, 0x03C7,
+    0x03C8, 0x03C9, 0x03CA, 0x03CB, 0x03CC, 0x03CD, 0x03CE, 0x0000};
+
+static const uint16_t esp_mail_charset_iso8859_9[128] PROGMEM = {
+    0x0080, 0x0081, 0x0082, 0x0083, 0x0084, 0x0085, 0x0086, 0x0087,
+    0x0088, 0x0089, 0x008A, 0x008B, 0x008C, 0x008D, 0x008E, 0x008F,
+    0x0090, 0x0091, 0x0092, 0x0093, 0x0094, 0x0095, 0x0096, 0x0097,
+    0x0098, 0x0099, 0x009A, 0x009B, 0x009C, 0x009D, 0x009E, 0x009F,
+    0x00A0, 0x00A1, 0x00A2, 0x00A3, 0x00A4, 0x00A5, 0x00A6, 0x00A7,
+    0x00A8, 0x00A9, 0x00AA, 0x00AB, 0x00AC, 0x00AD, 0x00AE, 0x00AF,
+    0x00B0, 0x00B1, 0x00B2, 0x00B3, 0x00B4, 0x00B5, 0x00B6, 0x00B7,
+    0x00B8, 0x00B9, 0x00BA, 0x00BB, 0x00BC, 0x00BD, 0x00BE, 0x00BF,
+    0x00C0, 0x00C1, 0x00C2, 0x00C3, 0x00C4, 0x00C5, 0x00C6, 0x00C7,
+    0x00C8, 0x00C9, 0x00CA, 0x00CB, 0x00CC, 0x00CD, 0x00CE, 0x00CF,
+    0x011E, 0x00D1, 0x00D2, 0x00D3, 0x00D4, 0x00D5, 0x00D6, 0x00D7,
+    0x00D8, 0x00D9, 0x00DA, 0x00DB, 0x00DC, 0x0130, 0x015E, 0x00DF,
+    0x00E0, 0x00E1, 0x00E2, 0x00E3, 0x00E4, 0x00E5, 0x00E6, 0x00E7,
+    0x00E8, 0x00E9, 0x00EA, 0x00EB, 0x00EC, 0x00ED, 0x00EE, 0x00EF,
+    0x011F, 0x00F1, 0x00F2, 0x00F3, 0x00F4, 0x00F5, 0x00F6, 0x00F7,
+    0x00F8, 0x00F9, 0x00FA, 0x00FB, 0x00FC, 0x0131, 0x015F, 0x00FF};
+
+static const uint16_t esp_mail_charset_iso8859_11[128] PROGMEM = {
+    0x0080, 0x0081, 0x0082, 0x0083, 0x0084, 0x0085, 0x0086, 0x0087,
+    0x0088, 0x0089, 0x008A, 0x008B, 0x008C, 0x008D, 0x008E, 0x008F,
+    0x0090, 0x0091, 0x0092, 0x0093, 0x0094, 0x0095, 0x0096, 0x0097,
+    0x0098, 0x0099, 0x009A, 0x009B, 0x009C, 0x009D, 0x009E, 0x009F,
+    0x00A0, 0x0E01, 0x0E02, 0x0E03, 0x0E04, 0x0E05, 0x0E06, 0x0E07,
+    0x0E08, 0x0E09, 0x0E0A, 0x0E0B, 0x0E0C, 0x0E0D, 0x0E0E, 0x0E0F,
+    0x0E10, 0x0E11, 0x0E12, 0x0E13, 0x0E14, 0x0E15, 0x0E16, 0x0E17,
+    0x0E18, 0x0E19, 0x0E1A, 0x0E1B, 0x0E1C, 0x0E1D, 0x0E1E, 0x0E1F,
+    0x0E20, 0x0E21, 0x0E22, 0x0E23, 0x0E24, 0x0E25, 0x0E26, 0x0E27,
+    0x0E28, 0x0E29, 0x0E2A, 0x0E2B, 0x0E2C, 0x0E2D, 0x0E2E, 0x0E2F,
+    0x0E30, 0x0E31, 0x0E32, 0x0E33, 0x0E34, 0x0E35, 0x0E36, 0x0E37,
+    0x0E38, 0x0E39, 0x0E3A, 0x0000, 0x0000, 0x0000, 0x0000, 0x0E3F,
+    0x0E40, 0x0E41, 0x0E42, 0x0E43, 0x0E44, 0x0E45, 0x0E46, 0x0E47,
+    0x0E48, 0x0E49, 0x0E4A, 0x0E4B, 0x0E4C, 0x0E4D, 0x0E4E, 0x0E4F,
+    0x0E50, 0x0E51, 0x0E52, 0x0E53, 0x0E54, 0x0E55, 0x0E56, 0x0E57,
+    0x0E58, 0x0E59, 0x0E5A, 0x0E5B, 0x0000, 0x0000, 0x0000, 0x0000};
+
+static const uint16_t esp_mail_charset_iso8859_15[128] PROGMEM = {
+    0x0080, 0x0081, 0x0082, 0x0083, 0x0084, 0x0085, 0x0086, 0x0087,
+    0x0088, 0x0089, 0x008A, 0x008B, 0x008C, 0x008D, 0x008E, 0x008F,
+    0x0090, 0x0091, 0x0092, 0x0093, 0x0094, 0x0095, 0x0096, 0x0097,
+    0x0098, 0x0099, 0x009A, 0x009B, 0x009C, 0x009D, 0x009E, 0x009F,
+    0x00A0, 0x00A1, 0x00A2, 0x00A3, 0x20AC, 0x00A5, 0x0160, 0x00A7,
+    0x0161, 0x00A9, 0x00AA, 0x00AB, 0x00AC, 0x00AD, 0x00AE, 0x00AF,
+    0x00B0, 0x00B1, 0x00B2, 0x00B3, 0x017D, 0x00B5, 0x00B6, 0x00B7,
+    0x017E, 0x00B9, 0x00BA, 0x00BB, 0x0152, 0x0153, 0x0178, 0x00BF,
+    0x00C0, 0x00C1, 0x00C2, 0x00C3, 0x00C4, 0x00C5, 0x00C6, 0x00C7,
+    0x00C8, 0x00C9, 0x00CA, 0x00CB, 0x00CC, 0x00CD, 0x00CE, 0x00CF,
+    0x00D0, 0x00D1, 0x00D2, 0x00D3, 0x00D4, 0x00D5, 0x00D6, 0x00D7,
+    0x00D8, 0x00D9, 0x00DA, 0x00DB, 0x00DC, 0x00DD, 0x00DE, 0x00DF,
+    0x00E0, 0x00E1, 0x00E2, 0x00E3, 0x00E4, 0x00E5, 0x00E6, 0x00E7,
+    0x00E8, 0x00E9, 0x00EA, 0x00EB, 0x00EC, 0x00ED, 0x00EE, 0x00EF,
+    0x00F0, 0x00F1, 0x00F2, 0x00F3, 0x00F4, 0x00F5, 0x00F6, 0x00F7,
+    0x00F8, 0x00F9, 0x00FA, 0x00FB, 0x00FC, 0x00FD, 0x00FE, 0x00FF};
+
+static const uint16_t esp_mail_charset_koi8_r[128] PROGMEM = {
+    0x2500, 0x2502, 0x250C, 0x2510, 0x2514, 0x2518, 0x251C, 0x2524,
+    0x252C, 0x2534, 0x253C, 0x2580, 0x2584, 0x2588, 0x258C, 0x2590,
+    0x2591, 0x2592, 0x2593, 0x2320, 0x25A0, 0x2219, 0x221A, 0x2248,
+    0x2264, 0x2265, 0x00A0, 0x2321, 0x00B0, 0x00B2, 0x00B7, 0x00F7,
+    0x2550, 0x2551, 0x2552, 0x0451, 0x2553, 0x2554, 0x2555, 0x2556,
+    0x2557, 0x2558, 0x2559, 0x255A, 0x255B, 0x255C, 0x255D, 0x255E,
+    0x255F, 0x2560, 0x2561, 0x0401, 0x2562, 0x2563, 0x2564, 0x2565,
+    0x2566, 0x2567, 0x2568, 0x2569, 0x256A, 0x256B, 0x256C, 0x00A9,
+    0x044E, 0x0430, 0x0431, 0x0446, 0x0434, 0x0435, 0x0444, 0x0433,
+    0x0445, 0x0438, 0x0439, 0x043A, 0x043B, 0x043C, 0x043D, 0x043E,
+    0x043F, 0x044F, 0x0440, 0x0441, 0x0442, 0x0443, 0x0436, 0x0432,
+    0x044C, 0x044B, 0x0437, 0x0448, 0x044D, 0x0449, 0x0447, 0x044A,
+    0x042E, 0x0410, 0x0411, 0x0426, 0x0414, 0x0415, 0x0424, 0x0413,
+    0x0425, 0x0418, 0x0419, 0x041A, 0x041B, 0x041C, 0x041D, 0x041E,
+    0x041F, 0x042F, 0x0420, 0x0421, 0x0422, 0x0423, 0x0416, 0x0412,
+    0x042C, 0x042B, 0x0417, 0x0428, 0x042D, 0x0429, 0x0427, 0x042A};
+
+static const uint16_t *const esp_mail_charset_tables[] = {
+    esp_mail_charset_windows_1250,
+    esp_mail_charset_windows_1251,
+    esp_mail_charset_windows_1252,
+    esp_mail_charset_windows_1253,
+    esp_mail_charset_windows_1254,
+    esp_mail_charset_windows_1257,
+    esp_mail_charset_windows_874,
+    esp_mail_charset_iso8859_2,
+    esp_mail_charset_iso8859_5,
+    esp_mail_charset_iso8859_7,
+    esp_mail_charset_iso8859_9,
+    esp_mail_charset_iso8859_11,
+    esp_mail_charset_iso8859_15,
+    esp_mail_charset_koi8_r};
+
+struct esp_mail_charset_t
+{
+    /* The charset name in lower case without separators e.g. windows1252 for windows-1252 */
+    char name[12];
+    /* The index of esp_mail_charset_tables, -1 for ISO-8859-1 which its bytes are the code points */
+    int8_t table;
+};
+
+/* The built-in single byte charsets that can be transcoded to UTF-8 */
+static const struct esp_mail_charset_t esp_mail_charsets[] PROGMEM = {
+    {"iso88591", -1},
+    {"latin1", -1},
+    {"usascii", -1},
+    {"windows1250", 0},
+    {"cp1250", 0},
+    {"windows1251", 1},
+    {"cp1251", 1},
+    {"windows1252", 2},
+    {"cp1252", 2},
+    {"windows1253", 3},
+    {"cp1253", 3},
+    {"windows1254", 4},
+    {"cp1254", 4},
+    {"windows1257", 5},
+    {"cp1257", 5},
+    {"windows874", 6},
+    {"cp874", 6},
+    {"iso88592", 7},
+    {"latin2", 7},
+    {"iso88595", 8},
+    {"iso88597", 9},
+    {"iso88599", 10},
+    {"latin5", 10},
+    {"iso885911", 11},
+    {"tis620", 11},
+    {"iso885915", 12},
+    {"latin9", 12},
+    {"koi8r", 13}};
+
+/* The user added single byte charset */
+struct esp_mail_charset_transcoder_t
+{
+    char name[16];
+    /* The code points of the bytes 0x80 - 0xff in RAM */
+    const uint16_t *table = nullptr;
+};
+
 #endif
 
 #if defined(MBFS_FLASH_FS) || defined(MBFS_SD_FS)
@@ -48,6 +48,7 @@
 #define IMAP_STATUS_CHECK_CAPABILITIES_FAILED -211
 #define IMAP_STATUS_NO_SUPPORTED_AUTH -212
 #define IMAP_STATUS_NO_MAILBOX_FOLDER_OPENED -213
+#define IMAP_STATUS_ERROR_CONTENT_SINK_TIMEOUT -214
 
 #endif
 
@@ -78,6 +78,39 @@ static SdFat sd_fat_fs;   //should declare as static here
 #define ESP_MAIL_DEFAULT_DEBUG_PORT Serial
 #endif
 
+// For dual core ESP32, the attachment and message body encoding runs in the separate task
+// on the other core while the previous encoded chunk is sending.
+// Uncomment this line to encode and send in the calling task instead.
+//#define ESP_MAIL_DISABLE_ENCODER_TASK
+
+// To cache the base64 encoded attachment and inline image data in flash (ESP_MAIL_DEFAULT_FLASH_FS)
+// for the attachments that its descr.cache was set. The next sending of the same file or blob will send
+// the cached data without reading and encoding again.
+//#define ESP_MAIL_ENABLE_ATTACHMENT_CACHE
+
+// The folder in flash to store the cache files
+//#define ESP_MAIL_ATTACHMENT_CACHE_DIR "/mail_cache"
+
+// To store the fetched message headers and part properties strings in the IMAPSession memory arena
+// which is freed all at once before the next fetch instead of allocating every string separately.
+// The arena is allocated in PSRAM when ESP_MAIL_USE_PSRAM is defined and PSRAM is available.
+//#define ESP_MAIL_ENABLE_IMAP_ARENA
+
+// The size of memory block that the IMAP arena allocates at a time
+//#define ESP_MAIL_IMAP_ARENA_BLOCK_SIZE 2048
+
+// For ESP32 and ESP8266, the TLS sessions of the recently connected servers are kept in memory
+// and resumed in the next secure connection to the same server host and port (abbreviated handshake).
+// Uncomment this line to do the full handshake in every connection instead.
+//#define ESP_MAIL_DISABLE_TLS_SESSION_CACHE
+
+// The maximum number of cached TLS sessions. The ESP32 session takes about 200 bytes or up to
+// a few kB when mbedTLS keeps the server certificate, the ESP8266 session takes about 100 bytes.
+//#define ESP_MAIL_TLS_SESSION_CACHE_SIZE 2
+
+// The time in ms that the cached TLS session can be resumed after its full handshake
+//#define ESP_MAIL_TLS_SESSION_CACHE_TTL (60 * 60 * 1000)
+
 // Enable IMAP class
 #define ENABLE_IMAP // comment this line to disable or exclude it
 
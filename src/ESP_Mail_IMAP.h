@@ -36,143 +36,211 @@
 
 #if defined(ENABLE_IMAP)
 
-int ESP_Mail_Client::decodeChar(const char *s)
+size_t ESP_Mail_Client::decodeTransfer(esp_mail_msg_xencoding xencoding, char *buf, size_t len)
 {
-    return 16 * hexval(*(s + 1)) + hexval(*(s + 2));
-}
+    // The decoded output is never longer than the input, write behind the read position
+    size_t j = 0;
 
-void ESP_Mail_Client::decodeQP_UTF8(const char *buf, char *out)
-{
-    char *tmp = strP(esp_mail_str_295);
-    while (*buf)
+    if (xencoding == esp_mail_msg_xencoding_base64)
     {
-        if (*buf != '=')
-            strcat_c(out, *buf++);
-        else if (*(buf + 1) == '\r' && *(buf + 2) == '\n')
-            buf += 3;
-        else if (*(buf + 1) == '\n')
-            buf += 2;
-        else if (!strchr(tmp, *(buf + 1)))
-            strcat_c(out, *buf++);
-        else if (!strchr(tmp, *(buf + 2)))
-            strcat_c(out, *buf++);
-        else
+        uint32_t acc = 0;
+        int n = 0;
+
+        for (size_t i = 0; i < len; i++)
+        {
+            int v = base64val(buf[i]);
+            if (v < 0)
+            {
+                if (buf[i] == '=')
+                    break;
+                continue;
+            }
+
+            acc = (acc << 6) | v;
+            if (++n == 4)
+            {
+                buf[j++] = acc >> 16;
+                buf[j++] = acc >> 8;
+                buf[j++] = acc;
+                acc = 0;
+                n = 0;
+            }
+        }
+
+        // the unpadded or padded last group
+        if (n == 2)
+            buf[j++] = acc >> 4;
+        else if (n == 3)
         {
-            strcat_c(out, decodeChar(buf));
-            buf += 3;
+            buf[j++] = acc >> 10;
+            buf[j++] = acc >> 2;
         }
     }
-    delP(&tmp);
-}
+    else if (xencoding == esp_mail_msg_xencoding_7bit || xencoding == esp_mail_msg_xencoding_8bit)
+    {
+        // rfc2045 section 2.7 and 2.8, no NULL and no more than 998 octets line,
+        // only 7-bit ASCII for 7bit
+        for (size_t i = 0; i < len && i < 998; i++)
+        {
+            uint8_t c = buf[i];
+            if (c > 0 && (c < 128 || xencoding == esp_mail_msg_xencoding_8bit))
+                buf[j++] = c;
+        }
 
-char *ESP_Mail_Client::decode7Bit_UTF8(char *buf)
-{
-    MB_String s;
+        // some special chars can't send in 7bit unless encoded as queoted printable string
+        if (xencoding == esp_mail_msg_xencoding_7bit)
+            j = decodeTransfer(esp_mail_msg_xencoding_qp, buf, j);
+    }
+    else if (xencoding == esp_mail_msg_xencoding_qp)
+    {
+        struct esp_mail_qp_decoder_t state;
+        j = decodeQP(state, buf, len, true);
+    }
+    else
+        j = len; // binary
 
-    // only non NULL and 7-bit ASCII are allowed
+    return j;
+}
 
-    // rfc2045 section 2.7
+size_t ESP_Mail_Client::decodeQP(struct esp_mail_qp_decoder_t &state, char *buf, size_t len, bool last)
+{
+    if (state.pendingLen > 0)
+    {
+        memmove(buf + state.pendingLen, buf, len);
+        memcpy(buf, state.pending, state.pendingLen);
+        len += state.pendingLen;
+        state.pendingLen = 0;
+    }
 
-    size_t len = buf ? strlen(buf) : 0;
+    // The decoded output is never longer than the input, write behind the read position
+    size_t j = 0;
 
     for (size_t i = 0; i < len; i++)
     {
-        if (buf[i] > 0 && buf[i] < 128 && i < 998)
-            s.append(1, buf[i]);
-    }
+        const char *p = (const char *)memchr(buf + i, '=', len - i);
+        size_t n = p ? p - buf - i : len - i;
 
-    // some special chars can't send in 7bit unless encoded as queoted printable string
-    char *decoded = (char *)newP(s.length() + 10);
-    decodeQP_UTF8(s.c_str(), decoded);
-    s.clear();
-    return decoded;
-}
-
-char *ESP_Mail_Client::decode8Bit_UTF8(char *buf)
-{
-    MB_String s;
+        // copy the literal run
+        if (n > 0)
+        {
+            if (j < i)
+                memmove(buf + j, buf + i, n);
+            i += n;
+            j += n;
+            if (!p)
+                break;
+        }
 
-    // only non NULL and less than 998 octet length are allowed
+        // keep the incomplete escape sequence for the next chunk
+        if (!last && len - i < 3 && (i + 1 == len || buf[i + 1] == '\r' || hexval(buf[i + 1]) >= 0))
+        {
+            state.pendingLen = len - i;
+            memcpy(state.pending, buf + i, state.pendingLen);
+            break;
+        }
 
-    // rfc2045 section 2.8
+        if (i + 2 < len && buf[i + 1] == '\r' && buf[i + 2] == '\n')
+            i += 2; // soft line break
+        else if (i + 1 < len && buf[i + 1] == '\n')
+            i++;
+        else if (i + 2 < len && hexval(buf[i + 1]) >= 0 && hexval(buf[i + 2]) >= 0)
+        {
+            buf[j++] = (hexval(buf[i + 1]) << 4) | hexval(buf[i + 2]);
+            i += 2;
+        }
+        else
+            buf[j++] = '=';
+    }
 
-    size_t len = buf ? strlen(buf) : 0;
+    return j;
+}
 
-    for (size_t i = 0; i < len; i++)
+char *ESP_Mail_Client::decodeScratch(IMAPSession *imap, size_t size)
+{
+    if (size > imap->_decodeScratchSize)
     {
-        if (buf[i] > 0 && i < 998)
-            s.append(1, buf[i]);
+        // grow geometrically to avoid reallocation for every longer line
+        size_t newSize = imap->_decodeScratchSize * 2;
+        if (newSize < size)
+            newSize = size;
+
+        delP(&imap->_decodeScratch);
+        imap->_decodeScratch = (char *)newP(newSize, false);
+        imap->_decodeScratchSize = imap->_decodeScratch ? newSize : 0;
     }
 
-    char *decoded = (char *)newP(s.length() + 1);
-    strcpy(decoded, s.c_str());
-    s.clear();
-    return decoded;
+    return imap->_decodeScratch;
 }
 
 void ESP_Mail_Client::decodeHeader(IMAPSession *imap, MB_String &headerField)
 {
+    // Nothing to decode
+    if (!imap->_charDecCallback && headerField.find("=?") == MB_String::npos)
+        return;
 
-    size_t p1 = 0, p2 = 0;
-    MB_String headerEnc;
-
-    while (headerField[p1] == ' ' && p1 < headerField.length() - 1)
-        p1++;
+    MB_String out;
 
-    if (headerField[p1] == '=' && headerField[p1 + 1] == '?')
+    if (imap->_charDecCallback)
     {
-        p2 = headerField.find("?", p1 + 2);
-        if (p2 != MB_String::npos)
+        size_t p1 = 0, p2 = 0;
+        MB_String headerEnc;
+
+        while (headerField[p1] == ' ' && p1 < headerField.length() - 1)
+            p1++;
+
+        if (headerField[p1] == '=' && headerField[p1 + 1] == '?')
         {
-            headerEnc = headerField.substr(p1 + 2, p2 - p1 - 2);
+            p2 = headerField.find("?", p1 + 2);
+            if (p2 != MB_String::npos)
+            {
+                headerEnc = headerField.substr(p1 + 2, p2 - p1 - 2);
+            }
         }
-    }
 
-    int bufSize = headerField.length()+ 10;
-    char *buf = (char *)newP(bufSize);
-    
-    // Content Q and B decodings
-    RFC2047Decoder.decode(mbfs, buf, headerField.c_str(), bufSize);
-    
-    // Char set decoding
-    if (imap->_charDecCallback)
-    {
+        // Content Q and B decodings, the char set decoding is done by user
+        RFC2047Decoder.decode(out, headerField.c_str(), headerField.length());
+
         IMAP_Decoding_Info decoding;
 
         decoding.charset = headerEnc.c_str();
-        decoding.data = buf;
+        decoding.data = out.c_str();
         decoding.type = IMAP_Decoding_Info::message_part_type_header;
 
         imap->_charDecCallback(&decoding);
 
         if (decoding.decodedString.length() > 0)
-        {
-            char *buf2 = (char *)newP(decoding.decodedString.length() + 1);
-            strcpy(buf2, decoding.decodedString.c_str());
-            delP(&buf);
-            buf = buf2;
-        }
+            out = decoding.decodedString.c_str();
     }
-    else if (getEncodingFromCharset(headerEnc.c_str()) == esp_mail_char_decoding_scheme_iso8859_1)
+    else
     {
-        int len = strlen(buf);
-        int olen = (len + 1) * 2;
-        unsigned char *out = (unsigned char *)newP(olen);
-        decodeLatin1_UTF8(out, &olen, (unsigned char *)buf, &len);
-        delP(&buf);
-        buf = (char *)out;
+        // Content Q and B decodings and char set decoding of each encoded word
+        RFC2047Decoder.decode(out, headerField.c_str(), headerField.length(), headerCharsetConv, this);
     }
-    else if (getEncodingFromCharset(headerEnc.c_str()) == esp_mail_char_decoding_scheme_tis620)
+
+    headerField.swap(out);
+}
+
+void ESP_Mail_Client::headerCharsetConv(void *arg, MB_String &out, const char *charset, size_t charsetLen, const char *data, size_t len)
+{
+    ESP_Mail_Client *client = (ESP_Mail_Client *)arg;
+
+    int transcoder = client->findTranscoder(charset, charsetLen);
+
+    if (transcoder < 0 || client->asciiLen(data, len) == len)
     {
-        size_t len2 = strlen(buf);
-        char *tmp = (char *)newP((len2 + 1) * 3);
-        decodeTIS620_UTF8(tmp, buf, len2);
-        delP(&buf);
-        buf = tmp;
+        out.append(data, len);
+        return;
     }
 
-    headerField = buf;
-    delP(&buf);
+    char buf[RFC2047_CHUNK_SIZE * 3];
+
+    while (len > 0)
+    {
+        size_t n = len > RFC2047_CHUNK_SIZE ? RFC2047_CHUNK_SIZE : len;
+        out.append(buf, client->transcodeUTF8(transcoder, data, n, buf));
+        data += n;
+        len -= n;
+    }
 }
 
 esp_mail_char_decoding_scheme ESP_Mail_Client::getEncodingFromCharset(const char *enc)
@@ -189,64 +257,156 @@ esp_mail_char_decoding_scheme ESP_Mail_Client::getEncodingFromCharset(const char
     return scheme;
 }
 
-void ESP_Mail_Client::decodeTIS620_UTF8(char *out, const char *in, size_t len)
+bool ESP_Mail_Client::addCharset(const char *charset, const uint16_t *table)
 {
-    // output is the 3-byte value UTF-8
-    int j = 0;
-    for (size_t i = 0; i < len; i++)
+    struct esp_mail_charset_transcoder_t transcoder;
+
+    if (!table || !charset || !charsetKey(transcoder.name, sizeof(transcoder.name), charset, strlen(charset)))
+        return false;
+
+    transcoder.table = table;
+
+    // The added charset overrides the built-in or previously added charset of the same name
+    for (size_t i = 0; i < _charsets.size(); i++)
     {
-        if (in[i] < 0x80)
-            out[j++] = in[i];
-        else if ((in[i] >= 0xa0 && in[i] < 0xdb) || (in[i] > 0xde && in[i] < 0xfc))
+        if (strcmp(_charsets[i].name, transcoder.name) == 0)
         {
-            int unicode = 0x0e00 + in[i] - 0xa0;
-            out[j++] = 0xe0 | ((unicode >> 12) & 0xf);
-            out[j++] = 0x80 | ((unicode >> 6) & 0x3f);
-            out[j++] = 0x80 | (unicode & 0x3f);
+            _charsets[i].table = table;
+            return true;
         }
     }
+
+    _charsets.push_back(transcoder);
+    return true;
+}
+
+bool ESP_Mail_Client::charsetKey(char *key, size_t size, const char *charset, size_t len)
+{
+    size_t n = 0;
+
+    for (size_t i = 0; i < len; i++)
+    {
+        char c = charset[i];
+
+        if (c >= 'A' && c <= 'Z')
+            c += 'a' - 'A';
+        else if (!(c >= 'a' && c <= 'z') && !(c >= '0' && c <= '9'))
+            continue;
+
+        if (n == size - 1)
+            return false;
+
+        key[n++] = c;
+    }
+
+    key[n] = 0;
+    return n > 0;
 }
 
-int ESP_Mail_Client::decodeLatin1_UTF8(unsigned char *out, int *outlen, const unsigned char *in, int *inlen)
+int ESP_Mail_Client::findTranscoder(const char *charset, size_t len)
 {
-    unsigned char *outstart = out;
-    const unsigned char *base = in;
-    const unsigned char *processed = in;
-    unsigned char *outend = out + *outlen;
-    const unsigned char *inend;
-    unsigned int c;
-    int bits;
+    char key[16];
+
+    if (!charsetKey(key, sizeof(key), charset, len))
+        return -1;
+
+    int builtins = sizeof(esp_mail_charsets) / sizeof(esp_mail_charsets[0]);
 
-    inend = in + (*inlen);
-    while ((in < inend) && (out - outstart + 5 < *outlen))
+    for (size_t i = 0; i < _charsets.size(); i++)
     {
-        c = *in++;
+        if (strcmp(_charsets[i].name, key) == 0)
+            return builtins + i;
+    }
+
+    for (int i = 0; i < builtins; i++)
+    {
+        if (strcmp_P(key, esp_mail_charsets[i].name) == 0)
+            return i;
+    }
+
+    return -1;
+}
+
+size_t ESP_Mail_Client::asciiLen(const char *in, size_t len)
+{
+    size_t i = 0;
 
-        /* assertion: c is a single UTF-4 value */
-        if (out >= outend)
+    // Test the high bits of 4 bytes at a time
+    while (i + sizeof(uint32_t) <= len)
+    {
+        uint32_t w;
+        memcpy(&w, in + i, sizeof(uint32_t));
+        if (w & 0x80808080UL)
             break;
-        if (c < 0x80)
+        i += sizeof(uint32_t);
+    }
+
+    while (i < len && (uint8_t)in[i] < 0x80)
+        i++;
+
+    return i;
+}
+
+size_t ESP_Mail_Client::transcodeUTF8(int transcoder, const char *in, size_t len, char *out)
+{
+    int builtins = sizeof(esp_mail_charsets) / sizeof(esp_mail_charsets[0]);
+    const uint16_t *table = nullptr;
+    bool flash = false;
+
+    if (transcoder >= builtins)
+        table = _charsets[transcoder - builtins].table;
+    else
+    {
+        struct esp_mail_charset_t charset;
+        memcpy_P(&charset, &esp_mail_charsets[transcoder], sizeof(charset));
+        if (charset.table > -1)
         {
-            *out++ = c;
-            bits = -6;
+            table = esp_mail_charset_tables[charset.table];
+            flash = true;
         }
-        else
+    }
+
+    size_t i = 0, j = 0;
+
+    while (i < len)
+    {
+        // Pass the ASCII run through
+        size_t n = asciiLen(in + i, len - i);
+        if (n > 0)
         {
-            *out++ = ((c >> 6) & 0x1F) | 0xC0;
-            bits = 0;
+            memcpy(out + j, in + i, n);
+            i += n;
+            j += n;
+            if (i == len)
+                break;
         }
 
-        for (; bits >= 0; bits -= 6)
+        uint8_t c = in[i++];
+        uint16_t u = c;
+
+        if (table)
         {
-            if (out >= outend)
-                break;
-            *out++ = ((c >> bits) & 0x3F) | 0x80;
+            u = flash ? pgm_read_word(&table[c - 0x80]) : table[c - 0x80];
+            if (u == 0)
+                u = 0xfffd; // replacement character
+        }
+
+        if (u < 0x80)
+            out[j++] = u;
+        else if (u < 0x800)
+        {
+            out[j++] = 0xc0 | (u >> 6);
+            out[j++] = 0x80 | (u & 0x3f);
+        }
+        else
+        {
+            out[j++] = 0xe0 | (u >> 12);
+            out[j++] = 0x80 | ((u >> 6) & 0x3f);
+            out[j++] = 0x80 | (u & 0x3f);
         }
-        processed = (const unsigned char *)in;
     }
-    *outlen = out - outstart;
-    *inlen = processed - base;
-    return (0);
+
+    return j;
 }
 
 bool ESP_Mail_Client::sendIMAPCommand(IMAPSession *imap, int msgIndex, int cmdCase)
@@ -356,16 +516,25 @@ bool ESP_Mail_Client::readMail(IMAPSession *imap, bool closeSession)
         for (size_t i = 0; i < imap->_headers.size(); i++)
             imap->_headers[i].part_headers.clear();
         imap->_headers.clear();
+#if defined(ESP_MAIL_USE_IMAP_ARENA)
+        imap->_arena.reset();
+#endif
 
-        if (imap->_config->fetch.uid.length() > 0 || imap->_config->fetch.number.length() > 0)
-            imap->_headerOnly = false;
-        else
-            imap->_headerOnly = true;
+        // _headerOnly of the new messages was set by fetchNewSinceIdle
+        if (!imap->_fetchNewMsg)
+        {
+            if (imap->_config->fetch.uid.length() > 0 || imap->_config->fetch.number.length() > 0)
+                imap->_headerOnly = false;
+            else
+                imap->_headerOnly = true;
+        }
     }
 
     imap->_rfc822_part_count = 0;
     imap->_mbif._availableItems = 0;
-    imap->_imap_msg_num.clear();
+    // the UIDs of new messages were fetched by fetchNewSinceIdle
+    if (!imap->_fetchNewMsg)
+        imap->_imap_msg_num.clear();
     imap->_uidSearch = false;
     imap->_mbif._searchCount = 0;
 
@@ -378,7 +547,9 @@ bool ESP_Mail_Client::readMail(IMAPSession *imap, bool closeSession)
             return handleIMAPError(imap, IMAP_STATUS_OPEN_MAILBOX_FAILED, false);
     }
 
-    if (imap->_headerOnly)
+    if (imap->_fetchNewMsg)
+        imap->_mbif._availableItems = imap->_imap_msg_num.size();
+    else if (imap->_headerOnly)
     {
         if (imap->_config->search.criteria.length() > 0)
         {
@@ -777,7 +948,9 @@ bool ESP_Mail_Client::readMail(IMAPSession *imap, bool closeSession)
                             return false;
 
                         imap->_imap_cmd = esp_mail_imap_command::esp_mail_imap_cmd_fetch_body_text;
-                        if (!handleIMAPResponse(imap, IMAP_STATUS_IMAP_RESPONSE_FAILED, closeSession))
+                        bool fetched = handleIMAPResponse(imap, IMAP_STATUS_IMAP_RESPONSE_FAILED, closeSession);
+                        endSink(imap);
+                        if (!fetched)
                             return false;
                     }
                     else if (cPart(imap)->attach_type != esp_mail_att_type_none && (mbfs->flashReady() || mbfs->sdReady()))
@@ -815,7 +988,9 @@ bool ESP_Mail_Client::readMail(IMAPSession *imap, bool closeSession)
                                         return false;
 
                                     imap->_imap_cmd = esp_mail_imap_command::esp_mail_imap_cmd_fetch_body_attachment;
-                                    if (!handleIMAPResponse(imap, IMAP_STATUS_IMAP_RESPONSE_FAILED, closeSession))
+                                    bool fetched = handleIMAPResponse(imap, IMAP_STATUS_IMAP_RESPONSE_FAILED, closeSession);
+                                    endSink(imap);
+                                    if (!fetched)
                                         return false;
                                     delay(0);
                                 }
@@ -1343,7 +1518,7 @@ size_t ESP_Mail_Client::imapSend(IMAPSession *imap, uint8_t *data, size_t size)
     return sent;
 }
 
-bool ESP_Mail_Client::mSetFlag(IMAPSession *imap, int msgUID, MB_StringPtr flag, uint8_t action, bool closeSession)
+bool ESP_Mail_Client::mSetFlag(IMAPSession *imap, int msgUID, MessageList *toSet, MB_StringPtr flag, uint8_t action, bool closeSession)
 {
     if (!reconnect(imap))
         return false;
@@ -1368,11 +1543,8 @@ bool ESP_Mail_Client::mSetFlag(IMAPSession *imap, int msgUID, MB_StringPtr flag,
     }
     else
     {
-        if (imap->_readOnlyMode || !imap->_mailboxOpened)
-        {
-            if (!imap->selectFolder(imap->_currentFolder.c_str(), false))
-                return false;
-        }
+        if (!imap->selectCurrentFolder(true))
+            return false;
     }
 
     if (imap->_readCallback)
@@ -1396,6 +1568,29 @@ bool ESP_Mail_Client::mSetFlag(IMAPSession *imap, int msgUID, MB_StringPtr flag,
             debugInfoP(esp_mail_str_255);
     }
 
+    if (toSet)
+    {
+        // one UID STORE command per sequence set, the .SILENT option suppresses the untagged FETCH of each message
+        MB_String args;
+        if (action == 0)
+            args = esp_mail_str_374;
+        else if (action == 1)
+            args = esp_mail_str_375;
+        else
+            args = esp_mail_str_376;
+
+        args += flag;
+        args += esp_mail_str_192;
+
+        if (!imap->sendSequenceSetCommands(toSet, esp_mail_str_249, args, esp_mail_imap_cmd_store, IMAP_STATUS_PARSE_FLAG_FAILED))
+            return false;
+
+        if (closeSession)
+            imap->closeSession();
+
+        return true;
+    }
+
     MB_String cmd = imap->prependTag(esp_mail_str_27, esp_mail_str_249);
     cmd += msgUID;
     if (action == 0)
@@ -1555,22 +1750,42 @@ struct esp_mail_message_header_t *ESP_Mail_Client::cHeader(IMAPSession *imap)
     return &imap->_headers[cIdx(imap)];
 }
 
-bool ESP_Mail_Client::parseHeaderState(IMAPSession *imap, const char *buf, PGM_P beginH, bool caseSensitive, struct esp_mail_message_header_t &header, int &headerState, esp_mail_imap_header_state state)
+int ESP_Mail_Client::getHeaderField(const char *buf, size_t len, bool caseSensitive)
 {
-    if (strcmpP(buf, 0, beginH, caseSensitive))
+    // The field name ends at colon and has no white space
+    const char *colon = (const char *)memchr(buf, ':', len);
+    if (!colon || colon == buf || buf[0] == ' ' || buf[0] == '\t')
+        return -1;
+
+    size_t nameLen = colon - buf;
+    uint8_t slot = esp_mail_imap_header_field_slots[(nameLen * 10 + foldCase(buf[0]) * 25 + foldCase(buf[nameLen - 1])) & 31];
+
+    if (slot > 0)
     {
-        headerState = state;
-        char *tmp = subStr(buf, beginH, NULL, 0, -1, caseSensitive);
-        if (tmp)
+        const struct esp_mail_imap_header_field_t *field = &esp_mail_imap_header_fields[slot - 1];
+        if (strlen_P(field->name) == nameLen + 1)
         {
-            setHeader(imap, tmp, header, headerState);
-            delP(&tmp);
+            size_t i = 0;
+            for (; i < nameLen; i++)
+            {
+                char c = pgm_read_byte(field->name + i);
+                if (caseSensitive ? buf[i] != c : foldCase(buf[i]) != foldCase(c))
+                    break;
+            }
 
-            return true;
+            if (i == nameLen)
+                return slot - 1;
         }
     }
 
-    return false;
+    for (size_t i = 0; i < nameLen; i++)
+    {
+        if (buf[i] == ' ' || buf[i] == '\t')
+            return -1;
+    }
+
+    // Other header field
+    return (int)(sizeof(esp_mail_imap_header_fields) / sizeof(esp_mail_imap_header_fields[0]));
 }
 
 void ESP_Mail_Client::parseHeaderResponse(IMAPSession *imap, char *buf, int bufLen, int &chunkIdx, struct esp_mail_message_header_t &header, int &headerState, int &octetCount, bool caseSensitive)
@@ -1603,67 +1818,37 @@ void ESP_Mail_Client::parseHeaderResponse(IMAPSession *imap, char *buf, int bufL
 
         chunkIdx++;
 
-        if (parseHeaderState(imap, buf, esp_mail_str_10, caseSensitive, header, headerState, esp_mail_imap_state_from))
-            return;
-
-        if (parseHeaderState(imap, buf, esp_mail_str_150, caseSensitive, header, headerState, esp_mail_imap_state_sender))
-            return;
-
-        if (parseHeaderState(imap, buf, esp_mail_str_11, caseSensitive, header, headerState, esp_mail_imap_state_to))
-            return;
-
-        if (parseHeaderState(imap, buf, esp_mail_str_12, caseSensitive, header, headerState, esp_mail_imap_state_cc))
-            return;
-
-        if (parseHeaderState(imap, buf, esp_mail_str_24, caseSensitive, header, headerState, esp_mail_imap_state_subject))
-            return;
-
-        if (parseHeaderState(imap, buf, esp_mail_str_46, caseSensitive, header, headerState, esp_mail_imap_state_return_path))
-            return;
-
-        if (parseHeaderState(imap, buf, esp_mail_str_184, caseSensitive, header, headerState, esp_mail_imap_state_reply_to))
-            return;
-
-        if (parseHeaderState(imap, buf, esp_mail_str_109, caseSensitive, header, headerState, esp_mail_imap_state_in_reply_to))
-            return;
-
-        if (parseHeaderState(imap, buf, esp_mail_str_107, caseSensitive, header, headerState, esp_mail_imap_state_references))
-            return;
-
-        if (parseHeaderState(imap, buf, esp_mail_str_134, caseSensitive, header, headerState, esp_mail_imap_state_comments))
-            return;
-
-        if (parseHeaderState(imap, buf, esp_mail_str_145, caseSensitive, header, headerState, esp_mail_imap_state_keywords))
-            return;
-
-        if (parseHeaderState(imap, buf, esp_mail_str_172, caseSensitive, header, headerState, esp_mail_imap_state_content_transfer_encoding))
-            return;
+        size_t len = strlen(buf);
+        int idx = getHeaderField(buf, len, caseSensitive);
 
-        if (parseHeaderState(imap, buf, esp_mail_str_190, caseSensitive, header, headerState, esp_mail_imap_state_accept_language))
+        if (idx < 0)
             return;
 
-        if (parseHeaderState(imap, buf, esp_mail_str_191, caseSensitive, header, headerState, esp_mail_imap_state_content_language))
+        if (idx == (int)(sizeof(esp_mail_imap_header_fields) / sizeof(esp_mail_imap_header_fields[0])))
+        {
+            // The unparsed field ends the folded lines of the previous field
+            headerState = 0;
             return;
+        }
 
-        if (parseHeaderState(imap, buf, esp_mail_str_99, caseSensitive, header, headerState, esp_mail_imap_state_date))
-            return;
+        headerState = esp_mail_imap_header_fields[idx].state;
+        size_t ofs = strlen_P(esp_mail_imap_header_fields[idx].name);
 
-        if (parseHeaderState(imap, buf, esp_mail_str_101, caseSensitive, header, headerState, esp_mail_imap_state_msg_id))
-            return;
+        while (ofs < len && (buf[ofs] == ' ' || buf[ofs] == '\r' || buf[ofs] == '\n'))
+            ofs++;
 
-        if (strcmpP(buf, 0, esp_mail_str_25, caseSensitive))
+        if (headerState == esp_mail_imap_state_content_type)
         {
-            headerState = esp_mail_imap_state_content_type;
-            tmp = subStr(buf, esp_mail_str_25, esp_mail_str_97, 0, caseSensitive);
-            if (tmp)
-            {
-                if (strpos(tmp, esp_mail_imap_multipart_sub_type_t::mixed, 0, caseSensitive) != -1)
-                    header.hasAttachment = true;
+            const char *end = (const char *)memchr(buf + ofs, ';', len - ofs);
+            size_t valueLen = end ? end - buf - ofs : len - ofs;
+            const char *mixed = esp_mail_imap_multipart_sub_type_t::mixed;
+            if (strpos(buf + ofs, valueLen, mixed, strlen(mixed), 0, caseSensitive) != -1)
+                header.hasAttachment = true;
 
-                setHeader(imap, buf, header, headerState);
-                delP(&tmp);
-            }
+            setHeader(imap, buf, header, headerState);
         }
+        else if (ofs < len)
+            setHeader(imap, buf + ofs, header, headerState);
     }
 }
 
@@ -2227,8 +2412,6 @@ bool ESP_Mail_Client::getPartHeaderProperties(IMAPSession *imap, const char *buf
                     int p4 = strpos(buf, "'", p3, caseSensitive);
                     if (p4 > -1)
                     {
-
-                        scheme = getEncodingFromCharset(buf);
                         int c1 = p4 + 1;
                         p4 = strpos(buf, "'", p4 + 1, caseSensitive);
                         int c2 = p4;
@@ -2237,6 +2420,8 @@ bool ESP_Mail_Client::getPartHeaderProperties(IMAPSession *imap, const char *buf
                             charset.append(buf + c1, c2 - c1);
                         }
                         p3 = p4 + 1;
+
+                        scheme = getEncodingFromCharset(charset.c_str());
                     }
 
                     int len = strlen(buf) - p3;
@@ -2273,22 +2458,18 @@ bool ESP_Mail_Client::getPartHeaderProperties(IMAPSession *imap, const char *buf
                         }
 
                     }
-                    else if (scheme == esp_mail_char_decoding_scheme_iso8859_1)
-                    {
-                        int ilen = strlen(tmp);
-                        int olen = (ilen + 1) * 2;
-                        char *buf2 = (char *)newP(olen);
-                        decodeLatin1_UTF8((unsigned char *)buf2, &olen, (unsigned char *)tmp, &ilen);
-                        delP(&tmp);
-                        tmp = buf2;
-                    }
-                    else if (scheme == esp_mail_char_decoding_scheme_tis620)
+                    else
                     {
-                        int ilen = strlen(tmp);
-                        char *buf2 = (char *)newP((ilen + 1) * 3);
-                        decodeTIS620_UTF8(buf2, tmp, ilen);
-                        delP(&tmp);
-                        tmp = buf2;
+                        int transcoder = findTranscoder(charset.c_str(), charset.length());
+                        if (transcoder > -1)
+                        {
+                            char *buf2 = urlDecode(tmp);
+                            delP(&tmp);
+                            size_t ilen = strlen(buf2);
+                            tmp = (char *)newP(ilen * 3 + 1);
+                            transcodeUTF8(transcoder, buf2, ilen, tmp);
+                            delP(&buf2);
+                        }
                     }
                 }
             }
@@ -2361,6 +2542,7 @@ void ESP_Mail_Client::closeTCPSession(IMAPSession *imap)
         _lastReconnectMillis = millis();
     }
     imap->_tcpConnected = false;
+    imap->_notifySet = false;
 }
 
 bool ESP_Mail_Client::reconnect(IMAPSession *imap, unsigned long dataTime, bool downloadRequest)
@@ -2469,7 +2651,7 @@ bool ESP_Mail_Client::handleIMAPResponse(IMAPSession *imap, int errCode, bool cl
     char *tmp = nullptr;
 
     // Flag used for CRLF inclusion in response reading in case 8bit/binary attachment and base64 encoded message
-    bool crLF = imap->_imap_cmd == esp_mail_imap_cmd_fetch_body_text && (cPart(imap)->xencoding == esp_mail_msg_xencoding_base64 || cPart(imap)->xencoding == esp_mail_msg_xencoding_binary);
+    bool crLF = imap->_imap_cmd == esp_mail_imap_cmd_fetch_body_text && (cPart(imap)->xencoding == esp_mail_msg_xencoding_base64 || cPart(imap)->xencoding == esp_mail_msg_xencoding_binary || cPart(imap)->xencoding == esp_mail_msg_xencoding_qp);
     crLF |= imap->_imap_cmd == esp_mail_imap_cmd_fetch_body_attachment && cPart(imap)->xencoding != esp_mail_msg_xencoding_base64;
 
     // custom cmd IDLE?, waiting incoming server response
@@ -2503,9 +2685,7 @@ bool ESP_Mail_Client::handleIMAPResponse(IMAPSession *imap, int errCode, bool cl
         {
             imap->_mbif.clear();
             imap->_mbif._msgCount = 0;
-            imap->_mbif._polling_status.argument.clear();
-            imap->_mbif._polling_status.messageNum = 0;
-            imap->_mbif._polling_status.type = imap_polling_status_type_undefined;
+            imap->_mbif.clearPollingStatus();
             imap->_mbif._idleTimeMs = 0;
             imap->_nextUID.clear();
             imap->_unseenMsgIndex.clear();
@@ -2517,9 +2697,9 @@ bool ESP_Mail_Client::handleIMAPResponse(IMAPSession *imap, int errCode, bool cl
             imap->_imap_msg_num.clear();
         }
 
-        // response buffer
+        // response buffer, with 2 extra bytes for the pending quoted-printable escape bytes
         chunkBufSize = ESP_MAIL_CLIENT_RESPONSE_BUFFER_SIZE;
-        response = (char *)newP(chunkBufSize + 1);
+        response = (char *)newP(chunkBufSize + 3);
 
         if (imap->_imap_cmd == esp_mail_imap_cmd_fetch_body_attachment || imap->_imap_cmd == esp_mail_imap_cmd_fetch_body_inline)
             lastBuf = (char *)newP(BASE64_CHUNKED_LEN + 1);
@@ -2604,7 +2784,7 @@ bool ESP_Mail_Client::handleIMAPResponse(IMAPSession *imap, int errCode, bool cl
                                 imap->_read_capability.auto_caps = true;
                         }
 
-                        while (imap->client.available())
+                        while (!imap->_pipelined && imap->client.available())
                         {
                             readLen = readLine(&(imap->client), response, chunkBufSize, true, octetCount);
                             if (readLen)
@@ -2668,6 +2848,10 @@ bool ESP_Mail_Client::handleIMAPResponse(IMAPSession *imap, int errCode, bool cl
                             parseGetUIDResponse(imap, response);
                         else if (imap->_imap_cmd == esp_mail_imap_cmd_get_flags)
                             parseGetFlagsResponse(imap, response);
+                        else if (imap->_imap_cmd == esp_mail_imap_cmd_get_msg_info)
+                            parseMessageInfoResponse(imap, response);
+                        else if (imap->_imap_cmd == esp_mail_imap_cmd_status)
+                            parseFolderStatusResponse(imap, response);
                         else if (imap->_imap_cmd == esp_mail_imap_cmd_idle)
                         {
                             completedResponse = response[0] == '+';
@@ -2675,6 +2859,8 @@ bool ESP_Mail_Client::handleIMAPResponse(IMAPSession *imap, int errCode, bool cl
 
                             imap->_last_host_check_ms = millis();
                         }
+                        else if (imap->_imap_cmd == esp_mail_imap_cmd_done)
+                            parseIdleLine(imap, response);
                         else if (imap->_imap_cmd == esp_mail_imap_cmd_fetch_body_header)
                         {
 
@@ -2874,7 +3060,12 @@ bool ESP_Mail_Client::handleIMAPResponse(IMAPSession *imap, int errCode, bool cl
             decodeHeader(imap, header.header_fields.references);
             decodeHeader(imap, header.header_fields.comments);
             decodeHeader(imap, header.header_fields.keywords);
-            imap->_headers.push_back(header);
+            {
+#if defined(ESP_MAIL_USE_IMAP_ARENA)
+                MB_ArenaScope scope(&imap->_arena);
+#endif
+                imap->_headers.push_back(header);
+            }
         }
 
         if (imap->_imap_cmd == esp_mail_imap_cmd_fetch_body_mime)
@@ -2904,7 +3095,12 @@ bool ESP_Mail_Client::handleIMAPResponse(IMAPSession *imap, int errCode, bool cl
                     }
                 }
 
-                cHeader(imap)->part_headers.push_back(part);
+                {
+#if defined(ESP_MAIL_USE_IMAP_ARENA)
+                    MB_ArenaScope scope(&imap->_arena);
+#endif
+                    cHeader(imap)->part_headers.push_back(part);
+                }
                 cHeader(imap)->message_data_count = cHeader(imap)->part_headers.size();
 
                 if (part.msg_type == esp_mail_msg_type_plain || part.msg_type == esp_mail_msg_type_enriched || part.msg_type == esp_mail_msg_type_html || part.attach_type == esp_mail_att_type_none || (part.attach_type == esp_mail_att_type_attachment && imap->_config->download.attachment) || (part.attach_type == esp_mail_att_type_inline && imap->_config->download.inlineImg))
@@ -3280,6 +3476,10 @@ bool ESP_Mail_Client::parseCapabilityResponse(IMAPSession *imap, char *buf, int
                 imap->_read_capability.literal_plus = true;
             if (strposP(buf, esp_mail_imap_response_26, 0) > -1)
                 imap->_read_capability.literal_minus = true;
+            if (strposP(buf, esp_mail_imap_response_27, 0) > -1)
+                imap->_read_capability.move = true;
+            if (strposP(buf, esp_mail_imap_response_28, 0) > -1)
+                imap->_read_capability.notify = true;
 
             return true;
         }
@@ -3348,102 +3548,69 @@ void ESP_Mail_Client::parseFoldersResponse(IMAPSession *imap, char *buf)
 bool ESP_Mail_Client::parseIdleResponse(IMAPSession *imap)
 {
 
-    int chunkBufSize = 0;
-
     if (!reconnect(imap))
         return false;
 
-    if (imap->client.connected())
-        chunkBufSize = imap->client.available();
-    else
+    if (!imap->client.connected())
         return false;
 
-    if (chunkBufSize > 0)
+    if (imap->client.available() > 0)
     {
-        chunkBufSize = ESP_MAIL_CLIENT_RESPONSE_BUFFER_SIZE;
+        int bufSize = ESP_MAIL_CLIENT_RESPONSE_BUFFER_SIZE;
 
-        char *buf = (char *)newP(chunkBufSize + 1);
-
-        int octetCount = 0;
+        if (!imap->_idleBuf)
+        {
+            imap->_idleBuf = (char *)newP(bufSize + 1);
+            imap->_idleBufLen = 0;
+        }
 
-        int readLen = MailClient.readLine(&(imap->client), buf, chunkBufSize, false, octetCount);
+        char *buf = imap->_idleBuf;
 
-        if (readLen > 0)
+        // drain all untagged responses available in this poll
+        while (imap->client.available() > 0)
         {
+            int octetCount = 0;
 
-            if (imap->_debugLevel > esp_mail_debug_level_basic)
-                esp_mail_debug((const char *)buf);
+            if (imap->_idleBufLen > 0 && buf[imap->_idleBufLen - 1] == '\r')
+            {
+                // the previous read ended between CR and LF, take the next byte to complete the line
+                int c = imap->client.read();
 
-            char *tmp = nullptr;
-            int p1 = -1;
-            bool exists = false;
+                if (c < 0)
+                    break;
 
-            p1 = strposP(buf, esp_mail_str_199, 0);
-            if (p1 != -1)
-            {
-                int numMsg = imap->_mbif._msgCount;
-                tmp = (char *)newP(p1);
-                strncpy(tmp, buf + 2, p1 - 1);
-                imap->_mbif._msgCount = atoi(tmp);
-                delP(&tmp);
-                exists = true;
-                imap->_mbif._folderChanged |= (int)imap->_mbif._msgCount != numMsg;
-                if ((int)imap->_mbif._msgCount > numMsg)
-                {
-                    imap->_mbif._polling_status.type = imap_polling_status_type_new_message;
-                    imap->_mbif._polling_status.messageNum = imap->_mbif._msgCount;
-                }
-                goto ex;
+                buf[imap->_idleBufLen++] = c;
             }
-
-            p1 = strposP(buf, esp_mail_str_333, 0);
-            if (p1 != -1)
+            else
             {
-                imap->_mbif._polling_status.type = imap_polling_status_type_remove_message;
-                tmp = (char *)newP(p1);
-                strncpy(tmp, buf + 2, p1 - 1);
-                imap->_mbif._polling_status.messageNum = atoi(tmp);
+                buf[imap->_idleBufLen] = 0;
+                int readLen = readLine(&(imap->client), buf + imap->_idleBufLen, bufSize - imap->_idleBufLen, true, octetCount);
 
-                if (imap->_mbif._polling_status.messageNum == imap->_mbif._msgCount && imap->_mbif._nextUID > 0)
-                    imap->_mbif._nextUID--;
+                if (readLen <= 0)
+                    break;
 
-                delP(&tmp);
-                imap->_mbif._folderChanged = true;
-                goto ex;
+                imap->_idleBufLen += readLen;
             }
 
-            p1 = strposP(buf, esp_mail_str_334, 0);
-            if (p1 != -1)
-            {
-                tmp = (char *)newP(p1);
-                strncpy(tmp, buf + 2, p1 - 1);
-                imap->_mbif._recentCount = atoi(tmp);
-                delP(&tmp);
-                goto ex;
-            }
+            int len = imap->_idleBufLen;
+            bool completed = len > 1 && buf[len - 2] == '\r' && buf[len - 1] == '\n';
 
-            p1 = strposP(buf, esp_mail_imap_response_7, 0);
-            if (p1 != -1)
-            {
-                tmp = (char *)newP(p1);
-                strncpy(tmp, buf + 2, p1 - 1);
-                imap->_mbif._polling_status.messageNum = atoi(tmp);
-                delP(&tmp);
+            // wait for the rest of line unless the buffer is full
+            if (!completed && len < bufSize - 1)
+                break;
 
-                imap->_mbif._polling_status.argument = buf;
-                imap->_mbif._polling_status.argument.erase(0, p1 + 8);
-                imap->_mbif._polling_status.argument.pop_back();
-                imap->_mbif._folderChanged = true;
-                imap->_mbif._polling_status.type = imap_polling_status_type_fetch_message;
-                goto ex;
-            }
+            if (completed)
+                buf[len - 2] = 0;
 
-        ex:
+            imap->_idleBufLen = 0;
 
-            imap->_mbif._floderChangedState = (imap->_mbif._folderChanged && exists) || imap->_mbif._polling_status.type == imap_polling_status_type_fetch_message;
+            if (imap->_debugLevel > esp_mail_debug_level_basic)
+                esp_mail_debug((const char *)buf);
+
+            parseIdleLine(imap, buf);
         }
 
-        delP(&buf);
+        imap->_mbif._floderChangedState = imap->_mbif._polling_events.size() > 0;
     }
 
     size_t imap_idle_tmo = imap->_config->limit.imap_idle_timeout;
@@ -3461,14 +3628,140 @@ bool ESP_Mail_Client::parseIdleResponse(IMAPSession *imap)
     return true;
 }
 
-void ESP_Mail_Client::parseGetUIDResponse(IMAPSession *imap, char *buf)
+void ESP_Mail_Client::parseIdleLine(IMAPSession *imap, char *buf)
 {
-    char *tmp = nullptr;
-    int p1 = strposP(buf, esp_mail_str_342, 0);
-    imap->_uid_tmp = 0;
+    if (buf[0] != '*')
+        return;
+
+    // the status of watched folder sent by NOTIFY
+    if (parseFolderStatusResponse(imap, buf))
+        return;
+
+    int p1 = strposP(buf, esp_mail_str_199, 0);
     if (p1 != -1)
     {
-        tmp = (char *)newP(20);
+        size_t numMsg = imap->_mbif._msgCount;
+        imap->_mbif._msgCount = atoi(buf + 2);
+        imap->_mbif._folderChanged |= imap->_mbif._msgCount != numMsg;
+        if (imap->_mbif._msgCount > numMsg)
+        {
+            // the first new message number, kept when the following EXISTS are merged
+            MB_String first;
+            first += numMsg + 1;
+            imap->_mbif.addPollingStatus(imap_polling_status_type_new_message, imap->_mbif._msgCount, first.c_str());
+        }
+        return;
+    }
+
+    p1 = strposP(buf, esp_mail_str_333, 0);
+    if (p1 != -1)
+    {
+        size_t msgNum = atoi(buf + 2);
+
+        if (msgNum == imap->_mbif._msgCount && imap->_mbif._nextUID > 0)
+            imap->_mbif._nextUID--;
+
+        imap->_mbif.addPollingStatus(imap_polling_status_type_remove_message, msgNum, "");
+        imap->_mbif._folderChanged = true;
+        return;
+    }
+
+    p1 = strposP(buf, esp_mail_str_334, 0);
+    if (p1 != -1)
+    {
+        imap->_mbif._recentCount = atoi(buf + 2);
+        return;
+    }
+
+    p1 = strposP(buf, esp_mail_imap_response_7, 0);
+    if (p1 != -1)
+    {
+        // the argument without the parentheses
+        MB_String argument = buf;
+        argument.erase(0, p1 + 8);
+        argument.pop_back();
+
+        imap->_mbif.addPollingStatus(imap_polling_status_type_fetch_message, atoi(buf + 2), argument.c_str());
+        imap->_mbif._folderChanged = true;
+    }
+}
+
+bool ESP_Mail_Client::parseFolderStatusResponse(IMAPSession *imap, char *buf)
+{
+    // e.g. * STATUS "Alerts" (MESSAGES 12 UIDNEXT 345 UNSEEN 2)
+    if (strposP(buf, esp_mail_imap_response_29, 0) != 0)
+        return false;
+
+    MB_String name;
+    char *p = buf + strlen_P(esp_mail_imap_response_29);
+
+    if (*p == '"')
+    {
+        p++;
+        while (*p && *p != '"')
+        {
+            if (*p == '\\' && *(p + 1))
+                p++;
+            name += *p++;
+        }
+    }
+    else
+    {
+        while (*p && *p != ' ')
+            name += *p++;
+    }
+
+    char *items = strchr(p, '(');
+    if (!items)
+        return true;
+
+    items++;
+    char *end = strchr(items, ')');
+    if (end)
+        *end = 0;
+
+    for (size_t i = 0; i < imap->_watchFolders.size(); i++)
+    {
+        struct esp_mail_imap_watch_folder_t *fd = &imap->_watchFolders[i];
+
+        if (strcmp(fd->name.c_str(), name.c_str()) != 0)
+            continue;
+
+        size_t msgCount = fd->msgCount;
+        uint32_t nextUID = fd->nextUID;
+
+        int p1 = strposP(items, esp_mail_str_384, 0);
+        if (p1 != -1)
+            msgCount = atoi(items + p1 + strlen_P(esp_mail_str_384));
+
+        p1 = strposP(items, esp_mail_str_385, 0);
+        if (p1 != -1)
+            nextUID = strtoul(items + p1 + strlen_P(esp_mail_str_385), NULL, 10);
+
+        // the first status is the reference to compare
+        if (fd->init && (msgCount != fd->msgCount || nextUID != fd->nextUID))
+        {
+            imap->_mbif.addPollingStatus(imap_polling_status_type_folder_status, msgCount, items, fd->name.c_str());
+            imap->_mbif._folderChanged = true;
+        }
+
+        fd->msgCount = msgCount;
+        fd->nextUID = nextUID;
+        fd->init = true;
+        break;
+    }
+
+    return true;
+}
+
+void ESP_Mail_Client::parseGetUIDResponse(IMAPSession *imap, char *buf)
+{
+    char *tmp = nullptr;
+    int p1 = strposP(buf, esp_mail_str_342, 0);
+    imap->_uid_tmp = 0;
+    if (p1 != -1)
+    {
+        tmp = (char *)newP(20);
         strncpy(tmp, buf + p1 + strlen_P(esp_mail_str_342), strlen(buf) - p1 - strlen_P(esp_mail_str_342) - 1);
         imap->_uid_tmp = atoi(tmp);
         delP(&tmp);
@@ -3491,6 +3784,51 @@ void ESP_Mail_Client::parseGetFlagsResponse(IMAPSession *imap, char *buf)
     }
 }
 
+void ESP_Mail_Client::parseMessageInfoResponse(IMAPSession *imap, char *buf)
+{
+    // e.g. * 12 FETCH (UID 345 FLAGS (\Seen))
+    if (buf[0] != '*' || (!imap->_msgInfoCallback && !imap->_fetchNewMsg))
+        return;
+
+    int p1 = strposP(buf, esp_mail_str_370, 0);
+    if (p1 == -1)
+        return;
+
+    IMAP_Message_Info info;
+    info.msgNum = atoi(buf + 1);
+
+    p1 += strlen_P(esp_mail_str_370);
+
+    int p2 = strposP(buf, esp_mail_str_137, p1);
+    if (p2 != -1)
+        info.uid = strtoul(buf + p2 + strlen_P(esp_mail_str_137), NULL, 10);
+
+    p2 = strposP(buf, esp_mail_str_371, p1);
+    if (p2 != -1)
+    {
+        char *flags = buf + p2 + strlen_P(esp_mail_str_371);
+        char *end = strchr(flags, ')');
+        if (end)
+            *end = 0;
+        info.flags = flags;
+    }
+
+    if (imap->_fetchNewMsg)
+    {
+        // UID FETCH n:* also returns the last message when its UID is less than n
+        if (info.uid > imap->_idleLastUID && (imap->_idleLastUID > 0 || (size_t)info.msgNum > imap->_idleMsgCount))
+        {
+            esp_mail_imap_msg_num_t msg_num;
+            msg_num.type = esp_mail_imap_msg_num_type_uid;
+            msg_num.value = info.uid;
+            imap->_imap_msg_num.push_back(msg_num);
+        }
+        return;
+    }
+
+    imap->_msgInfoCallback(info);
+}
+
 void ESP_Mail_Client::parseExamineResponse(IMAPSession *imap, char *buf)
 {
     char *tmp = NULL;
@@ -3737,7 +4075,7 @@ bool ESP_Mail_Client::parseAttachmentResponse(IMAPSession *imap, char *buf, int
                     cHeader(imap)->total_attach_data_size += cPart(imap)->attach_data_size;
                 }
 
-                sendStreamCB(imap, (void *)decoded, olen, chunkIdx, false);
+                bool sinkWritten = sendStreamCB(imap, (void *)decoded, olen, chunkIdx);
 
                 int write = olen;
                 if (mbfs->ready(mbfs_type imap->_config->storage.type))
@@ -3746,6 +4084,9 @@ bool ESP_Mail_Client::parseAttachmentResponse(IMAPSession *imap, char *buf, int
                 delP(&decoded);
 
                 if (write != (int)olen)
+                    downloadError(imap, MB_FS_ERROR_FILE_IO_ERROR);
+
+                if (write != (int)olen || !sinkWritten)
                     return false;
             }
 
@@ -3761,7 +4102,7 @@ bool ESP_Mail_Client::parseAttachmentResponse(IMAPSession *imap, char *buf, int
                 cHeader(imap)->total_attach_data_size += cPart(imap)->attach_data_size;
             }
 
-            sendStreamCB(imap, (void *)buf, bufLen, chunkIdx, false);
+            bool sinkWritten = sendStreamCB(imap, (void *)buf, bufLen, chunkIdx);
 
             int write = bufLen;
             if (mbfs->ready(mbfs_type imap->_config->storage.type))
@@ -3770,6 +4111,9 @@ bool ESP_Mail_Client::parseAttachmentResponse(IMAPSession *imap, char *buf, int
             delay(0);
 
             if (write != bufLen)
+                downloadError(imap, MB_FS_ERROR_FILE_IO_ERROR);
+
+            if (write != bufLen || !sinkWritten)
                 return false;
 
             if (!reconnect(imap))
@@ -3919,6 +4263,26 @@ void ESP_Mail_Client::decodeText(IMAPSession *imap, char *buf, int bufLen, int &
                 }
             }
 
+            // Build the decoding stages of this part
+            struct esp_mail_imap_decode_pipeline_t &pipeline = imap->_decodePipeline;
+
+            pipeline.download = dlMsg;
+            pipeline.toText = (rfc822_body_subtype && imap->_config->enable.rfc822) || (!rfc822_body_subtype && ((cPart(imap)->msg_type == esp_mail_msg_type_html && imap->_config->enable.html) || ((cPart(imap)->msg_type == esp_mail_msg_type_plain || cPart(imap)->msg_type == esp_mail_msg_type_enriched) && imap->_config->enable.text)));
+            pipeline.toFile = filePath.length() > 0 && downloadRequest;
+            pipeline.enable = imap->_config->download.rfc822 || imap->_config->download.html || imap->_config->download.text || pipeline.toText;
+            pipeline.xencoding = cPart(imap)->xencoding;
+            pipeline.qp.pendingLen = 0;
+            pipeline.charDecCallback = pipeline.toText && imap->_charDecCallback;
+            pipeline.transcoder = -1;
+
+            if (pipeline.toText && !pipeline.charDecCallback)
+            {
+                // The charset transcoder is resolved once per part
+                if (cPart(imap)->transcoder == -2)
+                    cPart(imap)->transcoder = findTranscoder(cPart(imap)->charset.c_str(), cPart(imap)->charset.length());
+                pipeline.transcoder = cPart(imap)->transcoder;
+            }
+
             return;
         }
         else
@@ -3936,9 +4300,9 @@ void ESP_Mail_Client::decodeText(IMAPSession *imap, char *buf, int bufLen, int &
     if (octetLength == 0)
         return;
 
-    bool enableDownloads = (imap->_config->download.rfc822 && rfc822_body_subtype) || (!rfc822_body_subtype && ((cPart(imap)->msg_type == esp_mail_msg_type_html && imap->_config->download.html) || ((cPart(imap)->msg_type == esp_mail_msg_type_plain || cPart(imap)->msg_type == esp_mail_msg_type_enriched) && imap->_config->download.text)));
+    struct esp_mail_imap_decode_pipeline_t &pipeline = imap->_decodePipeline;
 
-    if (imap->_config->download.rfc822 || imap->_config->download.html || imap->_config->download.text || (rfc822_body_subtype && imap->_config->enable.rfc822) || (!rfc822_body_subtype && ((cPart(imap)->msg_type == esp_mail_msg_type_html && imap->_config->enable.html) || ((cPart(imap)->msg_type == esp_mail_msg_type_plain || cPart(imap)->msg_type == esp_mail_msg_type_enriched) && imap->_config->enable.text))))
+    if (pipeline.enable)
     {
 
         if (cPart(imap)->octetCount + bufLen >= octetLength)
@@ -3955,170 +4319,99 @@ void ESP_Mail_Client::decodeText(IMAPSession *imap, char *buf, int bufLen, int &
             cPart(imap)->octetCount = octetCount;
 
         if (imap->_readCallback)
-            fetchReport(imap, 100 * cPart(imap)->octetCount / octetLength, enableDownloads);
+            fetchReport(imap, 100 * cPart(imap)->octetCount / octetLength, pipeline.download);
 
         if (cPart(imap)->octetCount <= octetLength)
         {
-            bool hrdBrk = cPart(imap)->xencoding == esp_mail_msg_xencoding_qp && cPart(imap)->octetCount < octetLength;
-
-            // remove soft break for QP
-            if (bufLen <= QP_ENC_MSG_LEN && buf[bufLen - 1] == '=' && cPart(imap)->xencoding == esp_mail_msg_xencoding_qp)
-            {
-                hrdBrk = false;
-                buf[bufLen - 1] = 0;
-                bufLen--;
-            }
-
+            // The transfer decoding stage, in place.
+            // The quoted-printable lines were read with CRLF, the soft breaks and
+            // the escape sequences split by the read buffer are handled by decoder state.
             size_t olen = 0;
-            char *decoded = nullptr;
-            MB_String str;
-            bool dontDeleteOrModify = false;
-
-            // decode the content based on the transfer decoding
-            if (cPart(imap)->xencoding == esp_mail_msg_xencoding_base64)
-            {
-                decoded = (char *)decodeBase64((const unsigned char *)buf, bufLen, &olen);
-            }
-            else if (cPart(imap)->xencoding == esp_mail_msg_xencoding_qp)
-            {
-                decoded = (char *)newP(bufLen + 10);
-                decodeQP_UTF8(buf, decoded);
-                olen = strlen(decoded);
-            }
-            else if (cPart(imap)->xencoding == esp_mail_msg_xencoding_7bit)
-            {
-                decoded = decode7Bit_UTF8(buf);
-                olen = strlen(decoded);
-            }
-            else if (cPart(imap)->xencoding == esp_mail_msg_xencoding_8bit)
-            {
-                decoded = decode8Bit_UTF8(buf);
-                olen = strlen(decoded);
-            }
+            if (pipeline.xencoding == esp_mail_msg_xencoding_qp)
+                olen = decodeQP(pipeline.qp, buf, bufLen, cPart(imap)->octetCount >= octetLength);
             else
-            {
-                // binary
-                dontDeleteOrModify = true;
-                decoded = buf;
-                olen = bufLen;
-            }
+                olen = decodeTransfer(pipeline.xencoding, buf, bufLen);
+            char *decoded = buf;
+            buf[olen] = 0;
 
-            if (decoded)
-            {
-                // charset? apply character decoding to the decoded or nonencoded content
+            IMAP_Decoding_Info decoding;
 
-                if ((rfc822_body_subtype && imap->_config->enable.rfc822) || (!rfc822_body_subtype && ((cPart(imap)->msg_type == esp_mail_msg_type_html && imap->_config->enable.html) || ((cPart(imap)->msg_type == esp_mail_msg_type_plain || cPart(imap)->msg_type == esp_mail_msg_type_enriched) && imap->_config->enable.text))))
+            if (pipeline.toText)
+            {
+                // The charset stage
+                if (pipeline.charDecCallback)
                 {
+                    decoding.charset = cPart(imap)->charset.c_str();
+                    decoding.data = decoded;
+                    decoding.type = IMAP_Decoding_Info::message_part_type_text;
 
-                    if (imap->_charDecCallback)
-                    {
-
-                        IMAP_Decoding_Info decoding;
-
-                        decoding.charset = cPart(imap)->charset.c_str();
-                        decoding.data = decoded;
-                        decoding.type = IMAP_Decoding_Info::message_part_type_text;
-
-                        imap->_charDecCallback(&decoding);
+                    imap->_charDecCallback(&decoding);
 
-                        if (decoding.decodedString.length() > 0)
-                        {
-                            char *buf2 = (char *)newP(decoding.decodedString.length() + 1);
-                            strcpy(buf2, decoding.decodedString.c_str());
-
-                            if (decoded && !dontDeleteOrModify)
-                                delP(&decoded);
-
-                            decoded = buf2;
-                            olen = strlen(buf2);
-                        }
-
-                    }
-                    else
+                    if (decoding.decodedString.length() > 0)
                     {
-
-                        if (getEncodingFromCharset(cPart(imap)->charset.c_str()) == esp_mail_char_decoding_scheme_iso8859_1)
-                        {
-                            int ilen = olen;
-                            int olen2 = (ilen + 1) * 2;
-                            unsigned char *tmp = (unsigned char *)newP(olen2);
-                            decodeLatin1_UTF8(tmp, &olen2, (unsigned char *)decoded, &ilen);
-
-                            if (decoded && !dontDeleteOrModify)
-                                delP(&decoded);
-
-                            olen = olen2;
-                            decoded = (char *)tmp;
-                        }
-                        else if (getEncodingFromCharset(cPart(imap)->charset.c_str()) == esp_mail_char_decoding_scheme_tis620)
-                        {
-                            char *out = (char *)newP((olen + 1) * 3);
-                            decodeTIS620_UTF8(out, decoded, olen);
-                            olen = strlen(out);
-                            if (decoded && !dontDeleteOrModify)
-                                delP(&decoded);
-                            decoded = out;
-                        }
+                        decoded = (char *)decoding.decodedString.c_str();
+                        olen = decoding.decodedString.length();
                     }
-
-                    if (cPart(imap)->text.length() < imap->_config->limit.msg_size)
+                }
+                else if (pipeline.transcoder > -1 && asciiLen(decoded, olen) < olen)
+                {
+                    // Pure ASCII content is passed through as is
+                    char *out = decodeScratch(imap, olen * 3);
+                    if (out)
                     {
-
-                        if (cPart(imap)->text.length() + olen < imap->_config->limit.msg_size)
-                        {
-                            cPart(imap)->textLen += olen;
-                            cPart(imap)->text.append(decoded, olen);
-                            if (hrdBrk)
-                            {
-                                cPart(imap)->text += MBSTRING_FLASH_MCR("\r\n");
-                                cPart(imap)->textLen += 2;
-                            }
-                        }
-                        else
-                        {
-                            int d = imap->_config->limit.msg_size - cPart(imap)->text.length();
-                            cPart(imap)->textLen += d;
-                            if (d > 0)
-                                cPart(imap)->text.append(decoded, d);
-
-                            if (hrdBrk)
-                            {
-                                cPart(imap)->text += MBSTRING_FLASH_MCR("\r\n");
-                                cPart(imap)->textLen += 2;
-                            }
-                        }
+                        olen = transcodeUTF8(pipeline.transcoder, decoded, olen, out);
+                        decoded = out;
                     }
                 }
 
-                if (filePath.length() > 0 && downloadRequest)
+                // The text output stage
+                if (cPart(imap)->text.length() < imap->_config->limit.msg_size)
                 {
-                    if (mbfs->ready(mbfs_type imap->_config->storage.type))
+
+                    if (cPart(imap)->text.length() + olen < imap->_config->limit.msg_size)
+                    {
+                        cPart(imap)->textLen += olen;
+                        cPart(imap)->text.append(decoded, olen);
+                    }
+                    else
                     {
-                        if (olen > 0)
-                            mbfs->write(mbfs_type imap->_config->storage.type, (uint8_t *)decoded, olen);
-                        if (hrdBrk)
-                            mbfs->write(mbfs_type imap->_config->storage.type, (uint8_t *)MBSTRING_FLASH_MCR("\r\n"), 2);
+                        int d = imap->_config->limit.msg_size - cPart(imap)->text.length();
+                        cPart(imap)->textLen += d;
+                        if (d > 0)
+                            cPart(imap)->text.append(decoded, d);
                     }
                 }
+            }
 
-                sendStreamCB(imap, (void *)decoded, olen, chunkIdx, hrdBrk);
-
-                if (decoded && !dontDeleteOrModify)
-                    delP(&decoded);
+            // The file output stage
+            if (pipeline.toFile)
+            {
+                if (mbfs->ready(mbfs_type imap->_config->storage.type))
+                {
+                    if (olen > 0)
+                        mbfs->write(mbfs_type imap->_config->storage.type, (uint8_t *)decoded, olen);
+                }
             }
+
+            // The stream output stage
+            sendStreamCB(imap, (void *)decoded, olen, chunkIdx);
         }
     }
 
     chunkIdx++;
 }
 
-void ESP_Mail_Client::sendStreamCB(IMAPSession *imap, void *buf, size_t len, int chunkIndex, bool hrdBrk)
+bool ESP_Mail_Client::sendStreamCB(IMAPSession *imap, void *buf, size_t len, int chunkIndex)
 {
-    if (imap->_mimeDataStreamCallback && len > 0)
-    {
+    if (!imap->_mimeDataStreamCallback && !imap->_contentSink)
+        return true;
 
-        MIME_Data_Stream_Info streaminfo;
+    MIME_Data_Stream_Info &streaminfo = imap->_streamInfo;
 
+    // The part information is set once per part
+    if (cPart(imap)->stream_state == 0)
+    {
+        streaminfo = MIME_Data_Stream_Info();
         streaminfo.uid = cHeader(imap)->message_uid;
         streaminfo.disposition = cPart(imap)->content_disposition.c_str();
         streaminfo.type = cPart(imap)->content_type.c_str();
@@ -4128,31 +4421,104 @@ void ESP_Mail_Client::sendStreamCB(IMAPSession *imap, void *buf, size_t len, int
         streaminfo.description = cPart(imap)->content_description.c_str();
         streaminfo.date = cPart(imap)->creation_date.c_str();
         streaminfo.filename = cPart(imap)->filename.c_str();
-        streaminfo.size = (cPart(imap)->sizeProp) ? cPart(imap)->attach_data_size : cPart(imap)->octetLen;
-
         streaminfo.name = cPart(imap)->name.c_str();
         streaminfo.octet_size = cPart(imap)->octetLen;
-        streaminfo.octet_count = cPart(imap)->octetCount;
-
-        streaminfo.isFirstData = chunkIndex == 1;
-        streaminfo.isLastData = !hrdBrk ? cPart(imap)->octetLen == cPart(imap)->octetCount : false;
-
-        streaminfo.data_size = len;
-        streaminfo.data = buf;
         streaminfo.flowed = cPart(imap)->plain_flowed;
         streaminfo.delsp = cPart(imap)->plain_delsp;
 
+        cPart(imap)->stream_state = 1;
+        cPart(imap)->sink_error = false;
+
+        if (imap->_contentSink)
+            imap->_contentSink->begin(streaminfo);
+    }
+    else if (cPart(imap)->stream_state == 2)
+        return true;
+
+    // The decoded size is known after the data was decoded
+    streaminfo.size = (cPart(imap)->sizeProp) ? cPart(imap)->attach_data_size : cPart(imap)->octetLen;
+    streaminfo.octet_count = cPart(imap)->octetCount;
+    streaminfo.isFirstData = chunkIndex == 1;
+    streaminfo.isLastData = cPart(imap)->octetLen == cPart(imap)->octetCount;
+    streaminfo.data_size = len;
+    streaminfo.data = buf;
+
+    if (imap->_mimeDataStreamCallback && len > 0)
         imap->_mimeDataStreamCallback(streaminfo);
 
-        if (hrdBrk)
+    bool ret = true;
+
+    if (imap->_contentSink && !cPart(imap)->sink_error)
+    {
+        if (len > 0)
         {
-            streaminfo.isFirstData = false;
-            streaminfo.isLastData = cPart(imap)->octetLen == cPart(imap)->octetCount;
-            streaminfo.data_size = 2;
-            streaminfo.data = (void *)MBSTRING_FLASH_MCR("\r\n");
-            imap->_mimeDataStreamCallback(streaminfo);
+            ret = writeSink(imap, (const uint8_t *)buf, len);
+            if (!ret)
+            {
+                // The sink will not get the rest of data
+                cPart(imap)->sink_error = true;
+                imap->_contentSink->end(false);
+                downloadError(imap, IMAP_STATUS_ERROR_CONTENT_SINK_TIMEOUT);
+            }
         }
+
+        if (ret && streaminfo.isLastData)
+            imap->_contentSink->end(true);
     }
+
+    if (streaminfo.isLastData)
+        cPart(imap)->stream_state = 2;
+
+    return ret;
+}
+
+bool ESP_Mail_Client::writeSink(IMAPSession *imap, const uint8_t *data, size_t len)
+{
+    unsigned long ms = millis();
+
+    while (len > 0)
+    {
+        size_t n = imap->_contentSink->write(data, len);
+
+        if (n > 0)
+        {
+            if (n > len)
+                n = len;
+            data += n;
+            len -= n;
+            ms = millis();
+            continue;
+        }
+
+        // The sink is paused, the server data is left in the network buffers
+        if (millis() - ms > ESP_MAIL_CONTENT_SINK_TIMEOUT)
+            return false;
+
+        // let the other tasks run to drain the sink
+        delay(1);
+    }
+
+    return true;
+}
+
+void ESP_Mail_Client::endSink(IMAPSession *imap)
+{
+    if (imap->_headers.size() == 0 || cHeader(imap)->part_headers.size() == 0 || cPart(imap)->stream_state != 1)
+        return;
+
+    cPart(imap)->stream_state = 2;
+
+    if (imap->_contentSink && !cPart(imap)->sink_error)
+    {
+        cPart(imap)->sink_error = true;
+        imap->_contentSink->end(false);
+    }
+}
+
+void ESP_Mail_Client::downloadError(IMAPSession *imap, int err)
+{
+    errorStatusCB(imap, err);
+    cPart(imap)->download_error = imap->errorReason().c_str();
 }
 
 void ESP_Mail_Client::prepareFilePath(IMAPSession *imap, MB_String &filePath, bool header)
@@ -4541,6 +4907,10 @@ String IMAPSession::errorReason()
         ret += esp_mail_str_153;
         break;
 
+    case IMAP_STATUS_ERROR_CONTENT_SINK_TIMEOUT:
+        ret += esp_mail_str_387;
+        break;
+
     case TCP_CLIENT_ERROR_CONNECTION_REFUSED:
         ret += esp_mail_str_345;
         break;
@@ -4707,11 +5077,35 @@ bool IMAPSession::mListen(bool recon)
 
     if (_mbif._idleTimeMs == 0)
     {
-        _mbif._polling_status.messageNum = 0;
-        _mbif._polling_status.type = imap_polling_status_type_undefined;
-        _mbif._polling_status.argument.clear();
-        _mbif._recentCount = 0;
-        _mbif._folderChanged = false;
+        if (!_idleTracking)
+        {
+            _idleTracking = true;
+            _idleLastUID = _mbif._nextUID > 0 ? _mbif._nextUID - 1 : 0;
+            _idleMsgCount = _mbif._msgCount;
+        }
+
+        // keep the status of watched folders that was checked while the listen was paused
+        if (!recon)
+        {
+            _mbif.clearPollingStatus();
+            _mbif._recentCount = 0;
+            _mbif._folderChanged = false;
+        }
+
+        _idleBufLen = 0;
+
+        if (_read_capability.notify && (_watchChanged || (!_notifySet && hasOtherWatchFolders())))
+        {
+            _watchChanged = false;
+
+            // check the status of watched folders instead when NOTIFY was rejected
+            if (!sendNotify(true))
+            {
+                if (!_tcpConnected)
+                    return false;
+                _read_capability.notify = false;
+            }
+        }
 
         MB_String s;
 
@@ -4766,9 +5160,7 @@ bool IMAPSession::mListen(bool recon)
         {
             _mbif._floderChangedState = false;
             _mbif._folderChanged = false;
-            _mbif._polling_status.messageNum = 0;
-            _mbif._polling_status.type = imap_polling_status_type_undefined;
-            _mbif._polling_status.argument.clear();
+            _mbif.clearPollingStatus();
             _mbif._recentCount = 0;
         }
 
@@ -4782,13 +5174,51 @@ bool IMAPSession::mListen(bool recon)
         if (host_check_interval < 30 * 1000 || host_check_interval > imap_idle_tmo)
             host_check_interval = 60 * 1000;
 
+        // the changes of selected folder are already reported while idling
+        if (!_notifySet && hasOtherWatchFolders())
+        {
+            size_t status_interval = _config->limit.folder_status_interval;
+
+            if (status_interval < 10 * 1000 || status_interval > imap_idle_tmo)
+                status_interval = 60 * 1000;
+
+            if (_lastFolderStatusMs == 0 || millis() - _lastFolderStatusMs > status_interval)
+            {
+                // no command is allowed while idling
+                if (!mStopListen(true))
+                    return false;
+
+                bool ret = checkWatchFolders();
+                _lastFolderStatusMs = millis();
+
+                if (!mListen(true))
+                    return false;
+
+                _mbif._floderChangedState = _mbif._polling_events.size() > 0;
+                return ret;
+            }
+        }
+
         if (millis() - _last_host_check_ms > host_check_interval && _tcpConnected)
         {
             _last_host_check_ms = millis();
 
-            IPAddress ip;
+            bool alive = client.connected();
 
-            if (client.hostByName(_sesson_cfg->server.host_name.c_str(), ip) != 1)
+            if (alive && _config->enable.idle_probe)
+            {
+                // the server responds to DONE and IDLE when the connection is alive
+                alive = mStopListen(true) && mListen(true);
+                _mbif._floderChangedState = _mbif._polling_events.size() > 0;
+            }
+            else if (alive)
+            {
+                // the address that was resolved when connecting is used within the DNS cache TTL
+                IPAddress ip;
+                alive = client.cachedHostByName(_sesson_cfg->server.host_name.c_str(), ip) == 1;
+            }
+
+            if (!alive)
             {
                 closeSession();
                 _mbif._idleTimeMs = millis();
@@ -4807,9 +5237,7 @@ bool IMAPSession::mStopListen(bool recon)
     _mbif._idleTimeMs = 0;
     _mbif._floderChangedState = false;
     _mbif._folderChanged = false;
-    _mbif._polling_status.messageNum = 0;
-    _mbif._polling_status.type = imap_polling_status_type_undefined;
-    _mbif._polling_status.argument.clear();
+    _mbif.clearPollingStatus();
     _mbif._recentCount = 0;
 
     if (!_tcpConnected || _currentFolder.length() == 0 || !_read_capability.idle)
@@ -4824,6 +5252,10 @@ bool IMAPSession::mStopListen(bool recon)
 
     if (!recon)
     {
+        // the STATUS of watched folders is only parsed while listening, it is set again by the next listen
+        if (_notifySet && !sendNotify(false))
+            return false;
+
         if (_readCallback)
         {
             MB_String s = esp_mail_str_340;
@@ -4842,6 +5274,197 @@ bool IMAPSession::folderChanged()
     return _mbif._floderChangedState;
 }
 
+bool IMAPSession::mWatchFolder(MB_StringPtr folder)
+{
+    MB_String name = folder;
+
+    if (name.length() == 0)
+        return false;
+
+    for (size_t i = 0; i < _watchFolders.size(); i++)
+    {
+        if (strcmp(_watchFolders[i].name.c_str(), name.c_str()) == 0)
+            return true;
+    }
+
+    struct esp_mail_imap_watch_folder_t fd;
+    fd.name = name;
+    _watchFolders.push_back(fd);
+    _watchChanged = true;
+
+    return true;
+}
+
+void IMAPSession::clearWatchFolders()
+{
+    _watchFolders.clear();
+    _watchChanged = _notifySet;
+}
+
+bool IMAPSession::sendNotify(bool set)
+{
+    MB_String cmd = prependTag(esp_mail_str_27, esp_mail_str_379);
+    size_t count = 0;
+
+    for (size_t i = 0; set && i < _watchFolders.size(); i++)
+    {
+        // the selected folder was included
+        if (strcmp(_watchFolders[i].name.c_str(), _currentFolder.c_str()) == 0)
+            continue;
+
+        if (count > 0)
+            cmd += ' ';
+        appendQuotedName(cmd, _watchFolders[i].name);
+        count++;
+    }
+
+    cmd += esp_mail_str_380;
+
+    if (count == 0)
+    {
+        if (!_notifySet)
+            return true;
+        cmd = prependTag(esp_mail_str_27, esp_mail_str_381);
+    }
+
+    if (_debug)
+        esp_mail_debug(cmd.c_str());
+
+    if (MailClient.imapSend(this, cmd.c_str(), true) == ESP_MAIL_CLIENT_TRANSFER_DATA_FAILED)
+        return false;
+
+    // the initial status of the watched folders is returned with the response
+    _imap_cmd = esp_mail_imap_command::esp_mail_imap_cmd_status;
+    if (!MailClient.handleIMAPResponse(this, IMAP_STATUS_BAD_COMMAND, false))
+        return false;
+
+    _notifySet = count > 0;
+
+    return true;
+}
+
+bool IMAPSession::checkWatchFolders()
+{
+    if (_debug)
+        MailClient.debugInfoP(esp_mail_str_386);
+
+    for (size_t i = 0; i < _watchFolders.size(); i++)
+    {
+        if (strcmp(_watchFolders[i].name.c_str(), _currentFolder.c_str()) == 0)
+            continue;
+
+        MB_String cmd = prependTag(esp_mail_str_27, esp_mail_str_382);
+        appendQuotedName(cmd, _watchFolders[i].name);
+        cmd += esp_mail_str_383;
+
+        if (MailClient.imapSend(this, cmd.c_str(), true) == ESP_MAIL_CLIENT_TRANSFER_DATA_FAILED)
+            return false;
+
+        _imap_cmd = esp_mail_imap_command::esp_mail_imap_cmd_status;
+        if (!MailClient.handleIMAPResponse(this, IMAP_STATUS_BAD_COMMAND, false) && !_tcpConnected)
+            return false;
+    }
+
+    return true;
+}
+
+void IMAPSession::appendQuotedName(MB_String &cmd, const MB_String &name)
+{
+    // parseFolderStatusResponse removes the escapes from the quoted name
+    cmd += esp_mail_str_136;
+    for (size_t i = 0; i < name.length(); i++)
+    {
+        if (name[i] == '"' || name[i] == '\\')
+            cmd += '\\';
+        cmd += name[i];
+    }
+    cmd += esp_mail_str_136;
+}
+
+bool IMAPSession::hasOtherWatchFolders()
+{
+    for (size_t i = 0; i < _watchFolders.size(); i++)
+    {
+        if (strcmp(_watchFolders[i].name.c_str(), _currentFolder.c_str()) != 0)
+            return true;
+    }
+
+    return false;
+}
+
+bool IMAPSession::fetchNewSinceIdle(bool headerOnly)
+{
+    if (_currentFolder.length() == 0 || !_config || !_idleTracking)
+        return false;
+
+    bool idling = _mbif._idleTimeMs > 0;
+
+    if (idling && !mStopListen(true))
+        return false;
+
+    MB_String cmd;
+
+    // fetch by message number when UIDNEXT was unknown
+    if (_idleLastUID > 0)
+    {
+        cmd = prependTag(esp_mail_str_27, esp_mail_str_142);
+        cmd += _idleLastUID + 1;
+    }
+    else
+    {
+        cmd = prependTag(esp_mail_str_27, esp_mail_str_143);
+        cmd += _idleMsgCount + 1;
+    }
+
+    cmd += ':';
+    cmd += esp_mail_str_183;
+    cmd += esp_mail_str_138;
+
+    if (_readCallback)
+    {
+        MB_String s = esp_mail_str_377;
+        MailClient.imapCB(this, "", false);
+        MailClient.imapCB(this, s.c_str(), false);
+    }
+
+    if (_debug)
+        MailClient.debugInfoP(esp_mail_str_378);
+
+    if (MailClient.imapSend(this, cmd.c_str(), true) == ESP_MAIL_CLIENT_TRANSFER_DATA_FAILED)
+        return false;
+
+    _imap_msg_num.clear();
+    _fetchNewMsg = true;
+    _imap_cmd = esp_mail_imap_command::esp_mail_imap_cmd_get_msg_info;
+    bool ret = MailClient.handleIMAPResponse(this, IMAP_STATUS_BAD_COMMAND, false);
+
+    if (ret && _imap_msg_num.size() > 0)
+    {
+        uint32_t lastUID = _idleLastUID;
+        for (size_t i = 0; i < _imap_msg_num.size(); i++)
+        {
+            if (_imap_msg_num[i].value > lastUID)
+                lastUID = _imap_msg_num[i].value;
+        }
+
+        _headerOnly = headerOnly;
+        ret = MailClient.readMail(this, false);
+
+        // The messages are offered again in the next call when they could not be read
+        if (ret)
+            _idleLastUID = lastUID;
+    }
+
+    _fetchNewMsg = false;
+    if (ret)
+        _idleMsgCount = _mbif._msgCount;
+
+    if (idling && _tcpConnected)
+        ret &= mListen(true);
+
+    return ret;
+}
+
 void IMAPSession::checkUID()
 {
     if (MailClient.strcmpP(_config->fetch.uid.c_str(), 0, esp_mail_str_140) || MailClient.strcmpP(_config->fetch.uid.c_str(), 0, esp_mail_str_212) ||
@@ -4929,6 +5552,11 @@ void IMAPSession::mimeDataStreamCallback(MIMEDataStreamCallback mimeDataStreamCa
     _mimeDataStreamCallback = mimeDataStreamCallback;
 }
 
+void IMAPSession::setContentSink(MailContentSink *sink)
+{
+    _contentSink = sink;
+}
+
 void IMAPSession::setSystemTime(time_t ts)
 {
     this->client.setSystemTime(ts);
@@ -5135,7 +5763,13 @@ bool IMAPSession::openMailbox(MB_StringPtr folder, esp_mail_imap_auth_mode mode,
     }
 
     if (!sameFolder)
+    {
         _currentFolder = folder;
+        _idleTracking = false;
+    }
+
+    // The failed SELECT/EXAMINE leaves no folder selected (RFC3501 p.33)
+    _mailboxOpened = false;
 
     MB_String s;
     if (_readCallback)
@@ -5185,6 +5819,16 @@ bool IMAPSession::openMailbox(MB_StringPtr folder, esp_mail_imap_auth_mode mode,
     return true;
 }
 
+bool IMAPSession::selectCurrentFolder(bool readWrite)
+{
+    // The folder selection remains valid until the connection, authentication,
+    // other folder selection or closing was changed, select again only on mode change.
+    if (_mailboxOpened && _currentFolder.length() > 0 && (!readWrite || !_readOnlyMode))
+        return true;
+
+    return selectFolder(_currentFolder.c_str(), !readWrite);
+}
+
 bool IMAPSession::getMailboxes(FoldersCollection &folders)
 {
     _folders.clear();
@@ -5337,6 +5981,44 @@ const char *IMAPSession::getFlags(int msgNum)
     return _flags_tmp.c_str();
 }
 
+bool IMAPSession::mGetMessageInfo(int from, int to, bool flags, imapMessageInfoCallback callback)
+{
+    if (_currentFolder.length() == 0 || from < 1 || !callback)
+        return false;
+
+    // no message in the range, the server may reject the FETCH of the messages that do not exist
+    if (_mbif._msgCount == 0 || (size_t)from > _mbif._msgCount)
+        return true;
+
+    if (to < 1 || (size_t)to > _mbif._msgCount)
+        to = _mbif._msgCount;
+
+    MB_String cmd = prependTag(esp_mail_str_27, esp_mail_str_143);
+    cmd += from;
+    cmd += ':';
+    cmd += to;
+    cmd += flags ? esp_mail_str_369 : esp_mail_str_138;
+
+    if (_readCallback)
+    {
+        MB_String s = flags ? esp_mail_str_279 : esp_mail_str_372;
+        MailClient.imapCB(this, s.c_str(), false);
+    }
+
+    if (_debug)
+        MailClient.debugInfoP(flags ? esp_mail_str_105 : esp_mail_str_373);
+
+    if (MailClient.imapSend(this, cmd.c_str(), true) == ESP_MAIL_CLIENT_TRANSFER_DATA_FAILED)
+        return false;
+
+    _msgInfoCallback = callback;
+    _imap_cmd = esp_mail_imap_command::esp_mail_imap_cmd_get_msg_info;
+    bool ret = MailClient.handleIMAPResponse(this, IMAP_STATUS_BAD_COMMAND, false);
+    _msgInfoCallback = NULL;
+
+    return ret;
+}
+
 bool IMAPSession::mSendCustomCommand(MB_StringPtr cmd, imapResponseCallback callback, MB_StringPtr tag)
 {
 
@@ -5377,6 +6059,10 @@ bool IMAPSession::mSendCustomCommand(MB_StringPtr cmd, imapResponseCallback call
     else
         _imap_custom_cmd = esp_mail_imap_cmd_custom;
 
+    // The selected folder state is unknown after the custom folder selection commands
+    if (MailClient.strpos(_cmd.c_str(), " SELECT ", 0, false) > -1 || MailClient.strpos(_cmd.c_str(), " EXAMINE ", 0, false) > -1 || MailClient.strpos(_cmd.c_str(), " CLOSE", 0, false) > -1 || MailClient.strpos(_cmd.c_str(), " UNSELECT", 0, false) > -1)
+        _mailboxOpened = false;
+
     if (_prev_imap_custom_cmd != _imap_custom_cmd || _imap_custom_cmd != esp_mail_imap_cmd_idle)
     {
         if (MailClient.imapSend(this, _cmd.c_str(), true) == ESP_MAIL_CLIENT_TRANSFER_DATA_FAILED)
@@ -5483,7 +6169,7 @@ bool IMAPSession::deleteMessages(MessageList *toDelete, bool expunge)
     if (toDelete->_list.size() > 0)
     {
 
-        if (!selectFolder(_currentFolder.c_str(), false))
+        if (!selectCurrentFolder(true))
             return false;
 
         if (_debug)
@@ -5492,20 +6178,9 @@ bool IMAPSession::deleteMessages(MessageList *toDelete, bool expunge)
             MailClient.debugInfoP(esp_mail_str_316);
         }
 
-        MB_String cmd = prependTag(esp_mail_str_27, esp_mail_str_249);
-        for (size_t i = 0; i < toDelete->_list.size(); i++)
-        {
-            if (i > 0)
-                cmd += esp_mail_str_263;
-            cmd += toDelete->_list[i];
-        }
-        cmd += esp_mail_str_315;
+        MB_String args = esp_mail_str_315;
 
-        if (MailClient.imapSend(this, cmd.c_str(), true) == ESP_MAIL_CLIENT_TRANSFER_DATA_FAILED)
-            return false;
-
-        _imap_cmd = esp_mail_imap_command::esp_mail_imap_cmd_store;
-        if (!MailClient.handleIMAPResponse(this, IMAP_STATUS_BAD_COMMAND, false))
+        if (!sendSequenceSetCommands(toDelete, esp_mail_str_249, args, esp_mail_imap_command::esp_mail_imap_cmd_store, IMAP_STATUS_BAD_COMMAND))
             return false;
 
         if (expunge)
@@ -5527,7 +6202,8 @@ bool IMAPSession::mCopyMessages(MessageList *toCopy, MB_StringPtr dest)
     if (toCopy->_list.size() > 0)
     {
 
-        if (!selectFolder(_currentFolder.c_str(), false))
+        // COPY works in the read-only (EXAMINE) mode too
+        if (!selectCurrentFolder(false))
             return false;
 
         if (_debug)
@@ -5537,20 +6213,57 @@ bool IMAPSession::mCopyMessages(MessageList *toCopy, MB_StringPtr dest)
             esp_mail_debug(s.c_str());
         }
 
-        MB_String cmd = prependTag(esp_mail_str_27, esp_mail_str_319);
-        for (size_t i = 0; i < toCopy->_list.size(); i++)
+        MB_String args = esp_mail_str_131;
+        args += dest;
+
+        if (!sendSequenceSetCommands(toCopy, esp_mail_str_319, args, esp_mail_imap_command::esp_mail_imap_cmd_store, IMAP_STATUS_BAD_COMMAND))
+            return false;
+    }
+
+    return true;
+}
+
+bool IMAPSession::mMoveMessages(MessageList *toMove, MB_StringPtr dest)
+{
+    if (toMove->_list.size() > 0)
+    {
+
+        if (!selectCurrentFolder(true))
+            return false;
+
+        if (_debug)
         {
-            if (i > 0)
-                cmd += esp_mail_str_263;
-            cmd += toCopy->_list[i];
+            MB_String s = esp_mail_str_366;
+            s += dest;
+            esp_mail_debug(s.c_str());
         }
-        cmd += esp_mail_str_131;
-        cmd += dest;
 
-        if (MailClient.imapSend(this, cmd.c_str(), true) == ESP_MAIL_CLIENT_TRANSFER_DATA_FAILED)
+        MB_String args = esp_mail_str_131;
+        args += dest;
+
+        // rfc6851, the server copies and expunges the messages in one command
+        if (_read_capability.move)
+            return sendSequenceSetCommands(toMove, esp_mail_str_367, args, esp_mail_imap_command::esp_mail_imap_cmd_store, IMAP_STATUS_BAD_COMMAND);
+
+        if (!sendSequenceSetCommands(toMove, esp_mail_str_319, args, esp_mail_imap_command::esp_mail_imap_cmd_store, IMAP_STATUS_BAD_COMMAND))
             return false;
 
-        _imap_cmd = esp_mail_imap_command::esp_mail_imap_cmd_store;
+        args = esp_mail_str_315;
+
+        if (!sendSequenceSetCommands(toMove, esp_mail_str_249, args, esp_mail_imap_command::esp_mail_imap_cmd_store, IMAP_STATUS_BAD_COMMAND))
+            return false;
+
+        // rfc4315, expunge only the moved messages and keep other messages that were marked as deleted
+        if (_read_capability.uidplus)
+        {
+            args.clear();
+            return sendSequenceSetCommands(toMove, esp_mail_str_368, args, esp_mail_imap_command::esp_mail_imap_cmd_expunge, IMAP_STATUS_BAD_COMMAND);
+        }
+
+        if (MailClient.imapSendP(this, prependTag(esp_mail_str_27, esp_mail_str_317).c_str(), true) == ESP_MAIL_CLIENT_TRANSFER_DATA_FAILED)
+            return false;
+
+        _imap_cmd = esp_mail_imap_command::esp_mail_imap_cmd_expunge;
         if (!MailClient.handleIMAPResponse(this, IMAP_STATUS_BAD_COMMAND, false))
             return false;
     }
@@ -5558,11 +6271,119 @@ bool IMAPSession::mCopyMessages(MessageList *toCopy, MB_StringPtr dest)
     return true;
 }
 
+void IMAPSession::getSequenceSets(MessageList *list, size_t maxLen, MB_VECTOR<MB_String> &sets)
+{
+    // sort the copy, the caller's list is left unchanged
+    MessageList sorted;
+    for (size_t i = 0; i < list->_list.size(); i++)
+        sorted._list.push_back(list->_list[i]);
+    sorted.sort();
+
+    MB_String set, range;
+    size_t i = 0;
+
+    while (i < sorted._list.size())
+    {
+        // the contiguous UIDs
+        size_t j = i;
+        while (j + 1 < sorted._list.size() && sorted._list[j + 1] == sorted._list[j] + 1)
+            j++;
+
+        range.clear();
+        range += sorted._list[i];
+        if (j > i)
+        {
+            range += ':';
+            range += sorted._list[j];
+        }
+
+        if (set.length() > 0 && set.length() + 1 + range.length() > maxLen)
+        {
+            sets.push_back(set);
+            set.clear();
+        }
+
+        if (set.length() > 0)
+            set += esp_mail_str_263;
+        set += range;
+
+        i = j + 1;
+    }
+
+    if (set.length() > 0)
+        sets.push_back(set);
+}
+
+bool IMAPSession::sendSequenceSetCommands(MessageList *list, PGM_P cmd, const MB_String &args, esp_mail_imap_command imapCmd, int errCode)
+{
+    MB_String prefix = prependTag(esp_mail_str_27, cmd);
+
+    size_t cmdSize = _config ? _config->limit.cmd_size : 1000;
+    size_t overhead = prefix.length() + args.length();
+    // the set should fit at least a range of two UIDs
+    size_t maxLen = cmdSize > overhead + 21 ? cmdSize - overhead : 21;
+
+    MB_VECTOR<MB_String> sets;
+    getSequenceSets(list, maxLen, sets);
+
+    _imap_cmd = imapCmd;
+
+    // Send the commands without waiting for the responses of previous commands
+    // up to the pipeline depth, the responses of the same tag are read in order.
+    // Every handleIMAPResponse call reads up to one tagged response and the received
+    // responses of the other commands are kept when the next command was sent.
+    size_t sent = 0, done = 0;
+    bool ret = true;
+
+    client.setKeepReceivedData(true);
+
+    while (done < sets.size())
+    {
+        while (sent < sets.size() && sent - done < ESP_MAIL_IMAP_PIPELINE_DEPTH)
+        {
+            MB_String s = prefix;
+            s += sets[sent];
+            s += args;
+
+            if (MailClient.imapSend(this, s.c_str(), true) == ESP_MAIL_CLIENT_TRANSFER_DATA_FAILED)
+            {
+                ret = false;
+                break;
+            }
+            sent++;
+        }
+
+        if (!ret)
+            break;
+
+        // the remaining data after the last tagged response is discarded as usual
+        _pipelined = done + 1 < sets.size();
+
+        if (!MailClient.handleIMAPResponse(this, errCode, false))
+        {
+            ret = false;
+            // the connection was lost
+            if (!_tcpConnected)
+                break;
+        }
+        done++;
+    }
+
+    _pipelined = false;
+    client.setKeepReceivedData(false);
+
+    return ret;
+}
+
 void IMAPSession::empty()
 {
     _nextUID.clear();
     _sdFileList.clear();
     clearMessageData();
+    MailClient.delP(&_decodeScratch);
+    _decodeScratchSize = 0;
+    MailClient.delP(&_idleBuf);
+    _idleBufLen = 0;
 }
 
 String IMAPSession::fileList()
@@ -5577,6 +6398,9 @@ void IMAPSession::clearMessageData()
         _headers[i].part_headers.clear();
     }
     _headers.clear();
+#if defined(ESP_MAIL_USE_IMAP_ARENA)
+    _arena.reset();
+#endif
     _imap_msg_num.clear();
     _folders.clear();
     _mbif._flags.clear();
@@ -1347,6 +1347,7 @@ bool ESP_Mail_Client::sendBlobAttachment(SMTPSession *smtp, SMTP_Message *msg, S
         data_info.size = att->blob.size;
         data_info.flashMem = att->_int.flash_blob;
         data_info.filename = att->descr.filename.c_str();
+        data_info.cache = att->descr.cache;
 
         if (!sendBase64(smtp, msg, data_info, true, cb))
             return false;
@@ -1406,6 +1407,20 @@ bool ESP_Mail_Client::sendBlobAttachment(SMTPSession *smtp, SMTP_Message *msg, S
     return false;
 }
 
+bool ESP_Mail_Client::sendStreamAttachment(SMTPSession *smtp, SMTP_Message *msg, SMTP_Attachment *att)
+{
+    esp_mail_smtp_send_base64_data_info_t data_info;
+
+    data_info.stream = att->stream.read;
+    data_info.size = att->stream.size;
+    data_info.filename = att->descr.filename.c_str();
+
+    // The data will be sent as is when it was already base64 encoded or no transfer encoding required
+    bool base64 = strcmp(att->descr.transfer_encoding.c_str(), Content_Transfer_Encoding::enc_base64) == 0 && strcmp(att->descr.transfer_encoding.c_str(), att->descr.content_encoding.c_str()) != 0;
+
+    return sendBase64(smtp, msg, data_info, base64, altIsCB(smtp));
+}
+
 bool ESP_Mail_Client::sendFile(SMTPSession *smtp, SMTP_Message *msg, SMTP_Attachment *att)
 {
     bool cb = altIsCB(smtp);
@@ -1417,6 +1432,7 @@ bool ESP_Mail_Client::sendFile(SMTPSession *smtp, SMTP_Message *msg, SMTP_Attach
 
         data_info.filename = att->descr.filename.c_str();
         data_info.storageType = att->file.storage_type;
+        data_info.cache = att->descr.cache;
 
         if (!sendBase64(smtp, msg, data_info, true, cb))
             return false;
@@ -1550,7 +1566,31 @@ bool ESP_Mail_Client::sendAttachments(SMTPSession *smtp, SMTP_Message *msg, cons
 
             cnt++;
 
-            if (att->file.storage_type == esp_mail_file_storage_type_none)
+            if (att->stream.read)
+            {
+                altSendCallback(smtp, att->descr.filename.c_str(), s.c_str(), false, false);
+
+                buf.clear();
+                getAttachHeader(buf, boundary, att, att->stream.size);
+
+                if (!sendBDAT(smtp, msg, buf.length(), false))
+                    return false;
+
+                if (!altSendData(buf, false, smtp, msg, false, false, esp_mail_smtp_cmd_undefined, esp_mail_smtp_status_code_0, SMTP_STATUS_UNDEFINED))
+                    return false;
+
+                if (!sendStreamAttachment(smtp, msg, att))
+                    return false;
+
+                if (!sendBDAT(smtp, msg, 2, false))
+                    return false;
+
+                MB_String str = esp_mail_str_34;
+
+                if (!altSendData(str, false, smtp, msg, false, false, esp_mail_smtp_cmd_undefined, esp_mail_smtp_status_code_0, SMTP_STATUS_UNDEFINED))
+                    return false;
+            }
+            else if (att->file.storage_type == esp_mail_file_storage_type_none)
             {
                 if (!att->blob.data)
                     continue;
@@ -1796,7 +1836,31 @@ bool ESP_Mail_Client::sendInline(SMTPSession *smtp, SMTP_Message *msg, const MB_
 
                 cnt++;
 
-                if (att->file.storage_type == esp_mail_file_storage_type_none)
+                if (att->stream.read)
+                {
+                    altSendCallback(smtp, att->descr.filename.c_str(), s.c_str(), false, false);
+
+                    buf.clear();
+                    getInlineHeader(buf, related, att, att->stream.size);
+
+                    if (!sendBDAT(smtp, msg, buf.length(), false))
+                        return false;
+
+                    if (!altSendData(buf, false, smtp, msg, false, false, esp_mail_smtp_cmd_undefined, esp_mail_smtp_status_code_0, SMTP_STATUS_UNDEFINED))
+                        return false;
+
+                    if (!sendStreamAttachment(smtp, msg, att))
+                        return false;
+
+                    if (!sendBDAT(smtp, msg, 2, false))
+                        return false;
+
+                    MB_String str = esp_mail_str_34;
+
+                    if (!altSendData(str, false, smtp, msg, false, false, esp_mail_smtp_cmd_undefined, esp_mail_smtp_status_code_0, SMTP_STATUS_UNDEFINED))
+                        return false;
+                }
+                else if (att->file.storage_type == esp_mail_file_storage_type_none)
                 {
                     if (!att->blob.data)
                         continue;
@@ -2216,7 +2280,10 @@ bool ESP_Mail_Client::sendPartText(SMTPSession *smtp, SMTP_Message *msg, uint8_t
         }
     }
     else if (rawContent)
-        encodingText(smtp, msg, type, header);
+    {
+        if (!encodingText(smtp, msg, type, header))
+            return false;
+    }
 
     header += esp_mail_str_34;
 
@@ -2493,26 +2560,23 @@ bool ESP_Mail_Client::sendFileBody(SMTPSession *smtp, SMTP_Message *msg, uint8_t
     return false;
 }
 
-void ESP_Mail_Client::encodingText(SMTPSession *smtp, SMTP_Message *msg, uint8_t type, MB_String &content)
+bool ESP_Mail_Client::encodingText(SMTPSession *smtp, SMTP_Message *msg, uint8_t type, MB_String &content)
 {
     if (type == esp_mail_msg_type_plain || type == esp_mail_msg_type_enriched)
     {
-        MB_String s = msg->text.content;
+        MB_String s;
 
         if (msg->text.flowed)
-            formatFlowedText(s);
+            formatFlowedText(msg->text.content, s);
+        else
+            s = msg->text.content;
 
         if (msg->text.transfer_encoding.length() > 0)
         {
             if (strcmp(msg->text.transfer_encoding.c_str(), Content_Transfer_Encoding::enc_base64) == 0)
                 content += encodeBase64Str((const unsigned char *)s.c_str(), s.length());
             else if (strcmp(msg->text.transfer_encoding.c_str(), Content_Transfer_Encoding::enc_qp) == 0)
-            {
-                char *out = (char *)newP(s.length() * 3 + 1);
-                encodeQP(s.c_str(), out);
-                content += out;
-                delP(&out);
-            }
+                return sendQP(smtp, msg, content, s.c_str(), s.length());
             else
                 content += s;
         }
@@ -2556,12 +2620,7 @@ void ESP_Mail_Client::encodingText(SMTPSession *smtp, SMTP_Message *msg, uint8_t
             if (strcmp(msg->html.transfer_encoding.c_str(), Content_Transfer_Encoding::enc_base64) == 0)
                 content += encodeBase64Str((const unsigned char *)s.c_str(), s.length());
             else if (strcmp(msg->html.transfer_encoding.c_str(), Content_Transfer_Encoding::enc_qp) == 0)
-            {
-                char *out = (char *)newP(msg->html.content.length() * 3 + 1);
-                encodeQP(msg->html.content.c_str(), out);
-                content += out;
-                delP(&out);
-            }
+                return sendQP(smtp, msg, content, s.c_str(), s.length());
             else
                 content += s;
         }
@@ -2569,45 +2628,94 @@ void ESP_Mail_Client::encodingText(SMTPSession *smtp, SMTP_Message *msg, uint8_t
             content += s;
         s.clear();
     }
+
+    return true;
 }
 
-void ESP_Mail_Client::encodeQP(const char *buf, char *out)
+size_t ESP_Mail_Client::encodeQP(const char *buf, size_t len, size_t &pos, char *out, size_t outLen, int &col)
 {
-    int n = 0, p = 0, pos = 0;
-    for (n = 0; *buf; buf++)
+    static const char hex[] = "0123456789ABCDEF";
+    size_t n = 0;
+
+    // the worst case output for one input character is the soft line break followed by an escape
+    while (pos < len && n + 6 <= outLen)
     {
-        if (n >= 73 && *buf != 10 && *buf != 13)
-        {
-            p = sprintf(out + pos, "=\r\n");
-            pos += p;
-            n = 0;
-        }
+        uint8_t c = (uint8_t)buf[pos];
 
-        if (*buf == 10 || *buf == 13)
+        if (c == 10 || c == 13)
         {
-            strcat_c(out, *buf);
+            out[n++] = c;
+            col = 0;
             pos++;
-            n = 0;
+            continue;
         }
-        else if (*buf < 32 || *buf == 61 || *buf > 126)
+
+        if (col >= 73)
         {
-            p = sprintf(out + pos, "=%02X", (unsigned char)*buf);
-            n += p;
-            pos += p;
+            out[n++] = '=';
+            out[n++] = '\r';
+            out[n++] = '\n';
+            col = 0;
         }
-        else if (*buf != 32 || (*(buf + 1) != 10 && *(buf + 1) != 13))
+
+        // escape the space only when it is the last character of the line (rfc 2045 section 6.7)
+        bool lineEnd = c == 32 && (pos + 1 == len || buf[pos + 1] == 10 || buf[pos + 1] == 13);
+
+        if (c < 32 || c == 61 || c > 126 || lineEnd)
         {
-            strcat_c(out, *buf);
-            n++;
-            pos++;
+            out[n++] = '=';
+            out[n++] = hex[c >> 4];
+            out[n++] = hex[c & 0x0f];
+            col += 3;
         }
         else
         {
-            p = sprintf(out + pos, "=20");
-            n += p;
-            pos += p;
+            out[n++] = c;
+            col++;
+        }
+
+        pos++;
+    }
+
+    return n;
+}
+
+bool ESP_Mail_Client::sendQP(SMTPSession *smtp, SMTP_Message *msg, MB_String &header, const char *buf, size_t len)
+{
+    if (!sendBDAT(smtp, msg, header.length(), false))
+        return false;
+
+    if (!altSendData(header, false, smtp, msg, false, false, esp_mail_smtp_cmd_undefined, esp_mail_smtp_status_code_0, SMTP_STATUS_UNDEFINED))
+        return false;
+
+    header.clear();
+
+    bool ret = true;
+    size_t pos = 0;
+    int col = 0;
+    size_t bufLen = ESP_MAIL_CLIENT_STREAM_CHUNK_SIZE * 2;
+    uint8_t *out = (uint8_t *)newP(bufLen, false);
+
+    while (pos < len)
+    {
+        size_t n = encodeQP(buf, len, pos, (char *)out, bufLen, col);
+
+        if (!sendBDAT(smtp, msg, n, false))
+        {
+            ret = false;
+            break;
+        }
+
+        if (!altSendData(out, n, smtp, msg, false, false, esp_mail_smtp_cmd_undefined, esp_mail_smtp_status_code_0, SMTP_STATUS_UNDEFINED))
+        {
+            ret = false;
+            break;
         }
     }
+
+    delP(&out);
+
+    return ret;
 }
 
 /** Add the soft line break to the long text line (rfc 3676)
@@ -2621,79 +2729,81 @@ void ESP_Mail_Client::encodeQP(const char *buf, char *out)
  * Some mail clients trim the space before the line break
  * which makes the soft line break cannot be seen.
  */
-void ESP_Mail_Client::formatFlowedText(MB_String &content)
+size_t ESP_Mail_Client::formatFlowedText(const char *src, size_t len, char *out)
 {
-    int count = 0;
-    MB_String qms;
-    int j = 0;
-    MB_VECTOR<MB_String> tokens;
-    char *stk = strP(esp_mail_str_34);
-    char *qm = strP(esp_mail_str_15);
-    splitTk(content, tokens, stk);
-    content.clear();
-    for (size_t i = 0; i < tokens.size(); i++)
-    {
-        if (tokens[i].length() > 0)
-        {
-            j = 0;
-            qms.clear();
-            while (tokens[i][j] == qm[0])
-            {
-                qms += qm;
-                j++;
-            }
-            softBreak(tokens[i], qms.c_str());
-            if (count > 0)
-                content += stk;
-            content += tokens[i];
-        }
-        else if (count > 0)
-            content += stk;
-        count++;
-    }
+    size_t n = 0, i = 0;
 
-    delP(&stk);
-    delP(&qm);
-    tokens.clear();
-}
+    while (i < len)
+    {
+        size_t lineEnd = i;
+        while (lineEnd < len && !(src[lineEnd] == '\r' && lineEnd + 1 < len && src[lineEnd + 1] == '\n'))
+            lineEnd++;
 
-void ESP_Mail_Client::softBreak(MB_String &content, const char *quoteMarks)
-{
-    size_t len = 0;
-    char *stk = strP(esp_mail_str_131);
-    MB_VECTOR<MB_String> tokens;
-    splitTk(content, tokens, stk);
-    content.clear();
-    for (size_t i = 0; i < tokens.size(); i++)
-    {
-        if (tokens[i].length() > 0)
+        /* the quote marks are repeated in every wrapped line */
+        size_t qmLen = 0;
+        while (i + qmLen < lineEnd && src[i + qmLen] == '>')
+            qmLen++;
+
+        size_t col = 0;
+        while (i < lineEnd)
         {
-            if (len + tokens[i].length() + 3 > FLOWED_TEXT_LEN)
+            if (src[i] == ' ')
             {
-                /* insert soft crlf */
-                content += stk;
-                content += esp_mail_str_34;
-
-                /* insert quote marks */
-                if (strlen(quoteMarks) > 0)
-                    content += quoteMarks;
-                content += tokens[i];
-                len = tokens[i].length();
+                i++;
+                continue;
             }
-            else
+
+            size_t w = i;
+            while (w < lineEnd && src[w] != ' ')
+                w++;
+
+            size_t wLen = w - i;
+
+            if (col > 0 && col + wLen + 3 > FLOWED_TEXT_LEN)
             {
-                if (len > 0)
+                /* insert soft crlf and quote marks */
+                if (out)
                 {
-                    content += stk;
-                    len += strlen(stk);
+                    memcpy(out + n, " \r\n", 3);
+                    memset(out + n + 3, '>', qmLen);
                 }
-                content += tokens[i];
-                len += tokens[i].length();
+                n += 3 + qmLen;
+                col = qmLen;
             }
+            else if (col > 0)
+            {
+                if (out)
+                    out[n] = ' ';
+                n++;
+                col++;
+            }
+
+            if (out)
+                memcpy(out + n, src + i, wLen);
+            n += wLen;
+            col += wLen;
+            i = w;
+        }
+
+        if (lineEnd < len)
+        {
+            if (out)
+                memcpy(out + n, "\r\n", 2);
+            n += 2;
+            i = lineEnd + 2;
         }
     }
-    delP(&stk);
-    tokens.clear();
+
+    return n;
+}
+
+void ESP_Mail_Client::formatFlowedText(const MB_String &src, MB_String &out)
+{
+    size_t len = formatFlowedText(src.c_str(), src.length(), NULL);
+    out.clear();
+    out.resize(len);
+    if (out.capacity() >= len)
+        formatFlowedText(src.c_str(), src.length(), &out[0]);
 }
 
 bool ESP_Mail_Client::altSendData(MB_String &s, bool newLine, SMTPSession *smtp, SMTP_Message *msg, bool addSendResult, bool getResponse, esp_mail_smtp_command cmd, esp_mail_smtp_status_code respCode, int errCode)
@@ -2881,9 +2991,14 @@ void ESP_Mail_Client::getInlineHeader(MB_String &header, const MB_String &bounda
 
     header += esp_mail_str_299;
     header += filename;
-    header += esp_mail_str_327;
-    header += size;
-    header += esp_mail_str_34;
+    if (size > 0)
+    {
+        header += esp_mail_str_327;
+        header += size;
+        header += esp_mail_str_34;
+    }
+    else
+        header += esp_mail_str_36;
 
     header += esp_mail_str_300;
     header += filename;
@@ -2954,9 +3069,14 @@ void ESP_Mail_Client::getAttachHeader(MB_String &header, const MB_String &bounda
     {
         header += esp_mail_str_30;
         header += filename;
-        header += esp_mail_str_327;
-        header += size;
-        header += esp_mail_str_34;
+        if (size > 0)
+        {
+            header += esp_mail_str_327;
+            header += size;
+            header += esp_mail_str_34;
+        }
+        else
+            header += esp_mail_str_36;
     }
 
     if (attach->descr.transfer_encoding.length() > 0)
@@ -3399,6 +3519,9 @@ MB_String ESP_Mail_Client::getMIMEBoundary(size_t len)
 
 int ESP_Mail_Client::chunkAvailable(SMTPSession *smtp, esp_mail_smtp_send_base64_data_info_t &data_info)
 {
+    if (data_info.stream)
+        return data_info.size > 0 ? data_info.size - data_info.dataIndex : 1;
+
     if (!data_info.rawPtr)
     {
         int fileSize = mbfs->size(mbfs_type data_info.storageType);
@@ -3414,210 +3537,420 @@ int ESP_Mail_Client::chunkAvailable(SMTPSession *smtp, esp_mail_smtp_send_base64
     return data_info.size - data_info.dataIndex;
 }
 
-int ESP_Mail_Client::getChunk(SMTPSession *smtp, esp_mail_smtp_send_base64_data_info_t &data_info, unsigned char *rawChunk, bool base64)
+void ESP_Mail_Client::closeChunk(esp_mail_smtp_send_base64_data_info_t &data_info)
+{
+    if (!data_info.rawPtr && !data_info.stream)
+    {
+        mbfs->close(mbfs_type data_info.storageType);
+    }
+}
+
+int ESP_Mail_Client::encodeChunk(esp_mail_smtp_send_base64_data_info_t &data_info, uint8_t *raw, uint8_t *out, bool base64)
 {
-    int available = chunkAvailable(smtp, data_info);
+    // The raw data length of one base64 encoded line
+    size_t lineLen = BASE64_CHUNKED_LEN * 3 / 4;
+    size_t len = base64 ? lineLen * UPLOAD_CHUNKS_NUM : (BASE64_CHUNKED_LEN + 2) * UPLOAD_CHUNKS_NUM;
 
-    if (available <= 0)
-        return available;
+    // The stream size can be unknown
+    if ((!data_info.stream || data_info.size > 0) && data_info.dataIndex + len > data_info.size)
+        len = data_info.size - data_info.dataIndex;
 
-    size_t size = base64 ? 3 : 4;
+    if (len == 0)
+        return 0;
 
-    if (data_info.dataIndex + size > data_info.size)
-        size = data_info.size - data_info.dataIndex;
+    // The data that already encoded is copied to the send buffer as is
+    uint8_t *dst = base64 ? raw : out;
 
-    if (!data_info.rawPtr)
+    if (data_info.stream)
     {
+        // Read until the chunk is full as the base64 padding is allowed only at the end of data
+        size_t readLen = 0;
+        while (readLen < len)
+        {
+            size_t n = data_info.stream(dst + readLen, len - readLen);
+            if (n == 0 || n > len - readLen)
+                break;
+            readLen += n;
+        }
 
-        int readLen = mbfs->read(mbfs_type data_info.storageType, rawChunk, size);
+        if (data_info.size > 0 && readLen < len)
+            return -1;
 
-        if (readLen >= 0)
-            data_info.dataIndex += readLen;
+        len = readLen;
 
-        return readLen;
+        if (len == 0)
+            return 0;
     }
-
-    if (data_info.flashMem)
-        memcpy_P(rawChunk, data_info.rawPtr + data_info.dataIndex, size);
+    else if (!data_info.rawPtr)
+    {
+        if (mbfs->read(mbfs_type data_info.storageType, dst, len) != (int)len)
+            return -1;
+    }
+    else if (data_info.flashMem)
+        memcpy_P(dst, data_info.rawPtr + data_info.dataIndex, len);
     else
-        memcpy(rawChunk, data_info.rawPtr + data_info.dataIndex, size);
+        memcpy(dst, data_info.rawPtr + data_info.dataIndex, len);
 
-    data_info.dataIndex += size;
+    data_info.dataIndex += len;
+
+    if (!base64)
+        return len;
 
-    return size;
+    uint8_t *pos = out;
+    const uint8_t *in = raw;
+    const uint8_t *end = raw + len;
+
+    while (end - in >= 3)
+    {
+        *pos++ = b64_index_table[in[0] >> 2];
+        *pos++ = b64_index_table[((in[0] & 0x03) << 4) | (in[1] >> 4)];
+        *pos++ = b64_index_table[((in[1] & 0x0f) << 2) | (in[2] >> 6)];
+        *pos++ = b64_index_table[in[2] & 0x3f];
+        in += 3;
+
+        if ((in - raw) % lineLen == 0)
+        {
+            *pos++ = 0x0d;
+            *pos++ = 0x0a;
+        }
+    }
+
+    // The remaining bytes are only available at the end of data
+    if (end - in)
+    {
+        *pos++ = b64_index_table[in[0] >> 2];
+        if (end - in == 1)
+        {
+            *pos++ = b64_index_table[(in[0] & 0x03) << 4];
+            *pos++ = '=';
+        }
+        else
+        {
+            *pos++ = b64_index_table[((in[0] & 0x03) << 4) | (in[1] >> 4)];
+            *pos++ = b64_index_table[(in[1] & 0x0f) << 2];
+        }
+        *pos++ = '=';
+    }
+
+    return pos - out;
 }
 
-void ESP_Mail_Client::closeChunk(esp_mail_smtp_send_base64_data_info_t &data_info)
+#if defined(ESP_MAIL_USE_ATTACHMENT_CACHE)
+
+void ESP_Mail_Client::getCacheKey(esp_mail_smtp_send_base64_data_info_t &data_info, MB_String &cacheFile, MB_String &key)
 {
-    if (!data_info.rawPtr)
+    // The cache file of each blob or file is overwritten when its content changed
+    MB_String name = data_info.rawPtr ? data_info.filename : mbfs->name(mbfs_type data_info.storageType);
+
+    // FNV-1a hash
+    uint32_t slot = 2166136261UL;
+    for (size_t i = 0; i < name.length(); i++)
+        slot = (slot ^ (uint8_t)name[i]) * 16777619UL;
+
+    cacheFile = ESP_MAIL_ATTACHMENT_CACHE_DIR;
+    cacheFile += '/';
+    cacheFile += MB_String(slot, 16);
+
+    // The long name is replaced by its hash to keep the key line within ESP_MAIL_ATTACHMENT_CACHE_KEY_LEN,
+    // the rest of key is up to 23 characters (size, last write time or content hash, separators and new line).
+    if (name.length() > ESP_MAIL_ATTACHMENT_CACHE_KEY_LEN - 32)
+        key = MB_String(slot, 16);
+    else
+        key = name;
+    key += ';';
+    key += data_info.size;
+    key += ';';
+
+    time_t lastWrite = data_info.rawPtr ? 0 : mbfs->lastWrite(mbfs_type data_info.storageType);
+
+    if (lastWrite > 0)
     {
-        mbfs->close(mbfs_type data_info.storageType);
+        key += (unsigned long)lastWrite;
+        return;
+    }
+
+    // Hash the content for blob or the file that its last write time is not available
+    uint32_t hash = 2166136261UL;
+
+    if (data_info.rawPtr)
+    {
+        for (size_t i = 0; i < data_info.size; i++)
+            hash = (hash ^ (data_info.flashMem ? pgm_read_byte(data_info.rawPtr + i) : data_info.rawPtr[i])) * 16777619UL;
     }
+    else
+    {
+        uint8_t *buf = (uint8_t *)newP(ESP_MAIL_CLIENT_STREAM_CHUNK_SIZE);
+        int readLen = 0;
+        while ((readLen = mbfs->read(mbfs_type data_info.storageType, buf, ESP_MAIL_CLIENT_STREAM_CHUNK_SIZE)) > 0)
+        {
+            for (int i = 0; i < readLen; i++)
+                hash = (hash ^ buf[i]) * 16777619UL;
+        }
+        delP(&buf);
+        mbfs->seek(mbfs_type data_info.storageType, 0);
+    }
+
+    key += MB_String(hash, 16);
 }
 
-bool ESP_Mail_Client::sendBase64(SMTPSession *smtp, SMTP_Message *msg, esp_mail_smtp_send_base64_data_info_t &data_info, bool base64, bool report)
+int ESP_Mail_Client::sendCache(SMTPSession *smtp, SMTP_Message *msg, const MB_String &cacheFile, const MB_String &key, uint8_t *buf, size_t bufLen)
 {
-    int size = chunkAvailable(smtp, data_info);
+    int size = mbfs->openCache(cacheFile, mb_fs_open_mode_read);
 
-    if (size <= 0)
-        return false;
-
-    data_info.size = size;
+    if (size <= (int)key.length())
+    {
+        mbfs->closeCache();
+        return 0;
+    }
 
-    bool ret = false;
+    // The first line of cache file is the cache key
+    size_t keyLen = key.length() + 1;
+    if (keyLen > ESP_MAIL_ATTACHMENT_CACHE_KEY_LEN || keyLen > bufLen)
+    {
+        mbfs->closeCache();
+        return 0;
+    }
 
-    uint32_t addr = altProgressPtr(smtp);
+    if (mbfs->readCache(buf, keyLen) != (int)keyLen || buf[keyLen - 1] != '\n' || memcmp(buf, key.c_str(), keyLen - 1) != 0)
+    {
+        mbfs->closeCache();
+        return 0;
+    }
 
-    size_t chunkSize = (BASE64_CHUNKED_LEN * UPLOAD_CHUNKS_NUM) + (2 * UPLOAD_CHUNKS_NUM);
-    int bufIndex = 0;
-    bool dataReady = false;
-    int encodedCount = 0;
-    int read = 0;
+    int ret = 1;
+    int readLen = 0;
 
-    if (!base64)
+    while ((readLen = mbfs->readCache(buf, bufLen)) > 0)
     {
-        if (data_info.size < chunkSize)
-            chunkSize = data_info.size;
+        if (!sendBDAT(smtp, msg, readLen, false) || !altSendData(buf, readLen, smtp, msg, false, false, esp_mail_smtp_cmd_undefined, esp_mail_smtp_status_code_0, SMTP_STATUS_UNDEFINED))
+        {
+            ret = -1;
+            break;
+        }
     }
 
-    uint8_t *buf = (uint8_t *)newP(chunkSize);
-    memset(buf, 0, chunkSize);
+    mbfs->closeCache();
 
-    uint8_t *rawChunk = (uint8_t *)newP(base64 ? 3 : 4);
+    return ret;
+}
 
-    if (report)
-        uploadReport(data_info.filename, addr, data_info.dataIndex / data_info.size);
+#endif
 
-    while (chunkAvailable(smtp, data_info))
+#if defined(ESP_MAIL_USE_ENCODER_TASK)
+
+void ESP_Mail_Client::encoderTask(void *param)
+{
+    esp_mail_smtp_encoder_task_t *task = (esp_mail_smtp_encoder_task_t *)param;
+    esp_mail_smtp_send_base64_chunk_t chunk;
+
+    // Wait for the free buffer, fill it and pass it to the sender until end of data or abort (invalid buffer index)
+    while (xQueueReceive(task->freeQueue, &chunk.index, portMAX_DELAY) == pdTRUE && chunk.index < 2)
     {
+        chunk.len = MailClient.encodeChunk(*task->data_info, task->raw, task->buf[chunk.index], task->base64);
+        chunk.dataIndex = task->data_info->dataIndex;
+        xQueueSend(task->readyQueue, &chunk, portMAX_DELAY);
+        if (chunk.len <= 0)
+            break;
+    }
 
-        if (chunkAvailable(smtp, data_info) >= base64 ? 3 : 1)
+    xSemaphoreGive(task->done);
+    vTaskDelete(NULL);
+}
+
+#endif
+
+bool ESP_Mail_Client::sendBase64(SMTPSession *smtp, SMTP_Message *msg, esp_mail_smtp_send_base64_data_info_t &data_info, bool base64, bool report)
+{
+    int size = chunkAvailable(smtp, data_info);
+
+    if (size <= 0)
+        return false;
+
+    if (data_info.stream)
+    {
+        // The stream can't be read twice, its encoded length for IMAP APPEND is calculated from the known size
+        if (imap && calDataLen)
         {
+            size_t lineLen = BASE64_CHUNKED_LEN * 3 / 4;
+            dataLen += base64 ? 4 * ((data_info.size + 2) / 3) + 2 * (data_info.size / lineLen) : data_info.size;
+            return data_info.size > 0;
+        }
+    }
+    else
+        data_info.size = size;
 
-            read = getChunk(smtp, data_info, rawChunk, base64);
+    bool ret = false;
 
-            if (!read)
-                goto ex;
+    uint32_t addr = altProgressPtr(smtp);
 
-            getBuffer(base64, buf, rawChunk, encodedCount, bufIndex, dataReady, read, chunkSize);
+    size_t chunkSize = (BASE64_CHUNKED_LEN + 2) * UPLOAD_CHUNKS_NUM;
 
-            if (dataReady)
-            {
+    // The progress is not available for unknown size stream
+    if (report && data_info.size > 0)
+        uploadReport(data_info.filename, addr, data_info.dataIndex / data_info.size);
 
-                if (!sendBDAT(smtp, msg, base64 ? bufIndex : bufIndex + 1, false))
-                    goto ex;
+    // The double send buffers, one is being filled while another one is being sent
+    uint8_t *buf[2] = {nullptr, nullptr};
+    uint8_t *raw = nullptr;
+    esp_mail_smtp_send_base64_chunk_t chunk;
 
-                if (!altSendData(buf, base64 ? bufIndex : bufIndex + 1, smtp, msg, false, false, esp_mail_smtp_cmd_undefined, esp_mail_smtp_status_code_0, SMTP_STATUS_UNDEFINED))
-                    goto ex;
+#if defined(ESP_MAIL_USE_ENCODER_TASK)
+    esp_mail_smtp_encoder_task_t task;
+    TaskHandle_t taskHandle = NULL;
+#endif
 
-                memset(buf, 0, chunkSize);
-                bufIndex = 0;
-            }
+    buf[0] = (uint8_t *)newP(chunkSize, false);
 
-            if (report)
-                uploadReport(data_info.filename, addr, 100 * data_info.dataIndex / data_info.size);
-        }
-        else if (base64)
+#if defined(ESP_MAIL_USE_ATTACHMENT_CACHE)
+
+    bool cacheWrite = false;
+    MB_String cacheFile;
+
+    if (base64 && data_info.cache && !data_info.stream)
+    {
+        MB_String key;
+        getCacheKey(data_info, cacheFile, key);
+
+        int cacheStatus = sendCache(smtp, msg, cacheFile, key, buf[0], chunkSize);
+
+        if (cacheStatus != 0)
         {
-            read = getChunk(smtp, data_info, rawChunk, base64);
-            if (!read)
-                goto ex;
+            ret = cacheStatus > 0;
+            goto ex;
         }
+
+        // Cache miss, store the encoded data while sending
+        key += '\n';
+        cacheWrite = mbfs->openCache(cacheFile, mb_fs_open_mode_write) == 0 && mbfs->writeCache((const uint8_t *)key.c_str(), key.length()) == (int)key.length();
     }
 
-    closeChunk(data_info);
+#endif
 
     if (base64)
+        raw = (uint8_t *)newP(BASE64_CHUNKED_LEN * 3 / 4 * UPLOAD_CHUNKS_NUM, false);
+
+#if defined(ESP_MAIL_USE_ENCODER_TASK)
+
+    // Use the encoder task only when data is larger than one chunk,
+    // the stream read callback is always called from the calling task
+    if (!data_info.stream && data_info.size > BASE64_CHUNKED_LEN * UPLOAD_CHUNKS_NUM)
     {
-        if (bufIndex > 0)
-        {
-            if (!sendBDAT(smtp, msg, bufIndex, false))
-                goto ex;
+        buf[1] = (uint8_t *)newP(chunkSize, false);
+        task.freeQueue = xQueueCreate(2, sizeof(uint8_t));
+        task.readyQueue = xQueueCreate(2, sizeof(esp_mail_smtp_send_base64_chunk_t));
+        task.done = xSemaphoreCreateBinary();
+    }
 
-            if (!altSendData(buf, bufIndex, smtp, msg, false, false, esp_mail_smtp_cmd_undefined, esp_mail_smtp_status_code_0, SMTP_STATUS_UNDEFINED))
-                goto ex;
-        }
+    if (buf[1] && task.freeQueue && task.readyQueue && task.done)
+    {
+        task.data_info = &data_info;
+        task.buf[0] = buf[0];
+        task.buf[1] = buf[1];
+        task.raw = raw;
+        task.base64 = base64;
 
-        if (read)
+        for (uint8_t i = 0; i < 2; i++)
+            xQueueSend(task.freeQueue, &i, 0);
+
+        xTaskCreatePinnedToCore(encoderTask, "mailEncoder", ESP_MAIL_ENCODER_TASK_STACK_SIZE, &task, uxTaskPriorityGet(NULL), &taskHandle, xPortGetCoreID() == 0 ? 1 : 0);
+    }
+
+    if (taskHandle)
+    {
+        while (xQueueReceive(task.readyQueue, &chunk, portMAX_DELAY) == pdTRUE)
         {
-            memset(buf, 0, chunkSize);
-            bufIndex = 0;
-            buf[bufIndex++] = b64_index_table[rawChunk[0] >> 2];
-            if (read == 1)
+            if (chunk.len <= 0)
             {
-                buf[bufIndex++] = b64_index_table[(rawChunk[0] & 0x03) << 4];
-                buf[bufIndex++] = '=';
+                ret = chunk.len == 0;
+                break;
             }
-            else
+
+            if (!sendBDAT(smtp, msg, chunk.len, false) || !altSendData(buf[chunk.index], chunk.len, smtp, msg, false, false, esp_mail_smtp_cmd_undefined, esp_mail_smtp_status_code_0, SMTP_STATUS_UNDEFINED))
             {
-                buf[bufIndex++] = b64_index_table[((rawChunk[0] & 0x03) << 4) | (rawChunk[1] >> 4)];
-                buf[bufIndex++] = b64_index_table[(rawChunk[1] & 0x0f) << 2];
+                // Stop the encoder task
+                chunk.index = 2;
+                xQueueSend(task.freeQueue, &chunk.index, portMAX_DELAY);
+                break;
             }
-            buf[bufIndex++] = '=';
 
-            if (!sendBDAT(smtp, msg, bufIndex, false))
-                goto ex;
+#if defined(ESP_MAIL_USE_ATTACHMENT_CACHE)
+            if (cacheWrite)
+                cacheWrite = mbfs->writeCache(buf[chunk.index], chunk.len) == chunk.len;
+#endif
 
-            if (!altSendData(buf, bufIndex, smtp, msg, false, false, esp_mail_smtp_cmd_undefined, esp_mail_smtp_status_code_0, SMTP_STATUS_UNDEFINED))
-                goto ex;
+            if (report)
+                uploadReport(data_info.filename, addr, 100 * chunk.dataIndex / data_info.size);
+
+            xQueueSend(task.freeQueue, &chunk.index, portMAX_DELAY);
         }
-    }
 
-    ret = true;
+        xSemaphoreTake(task.done, portMAX_DELAY);
+    }
 
-    if (report)
-        uploadReport(data_info.filename, addr, 100);
+    if (task.freeQueue)
+        vQueueDelete(task.freeQueue);
 
-ex:
-    delP(&buf);
-    delP(&rawChunk);
-    
-    if (!ret)
-        closeChunk(data_info);
+    if (task.readyQueue)
+        vQueueDelete(task.readyQueue);
 
-    return ret;
-}
+    if (task.done)
+        vSemaphoreDelete(task.done);
 
-void ESP_Mail_Client::getBuffer(bool base64, uint8_t *out, uint8_t *in, int &encodedCount, int &bufIndex, bool &dataReady, int &size, size_t chunkSize)
-{
-    if (base64)
+    if (!taskHandle)
+#endif
     {
-        size = 0;
-        out[bufIndex++] = b64_index_table[in[0] >> 2];
-        out[bufIndex++] = b64_index_table[((in[0] & 0x03) << 4) | (in[1] >> 4)];
-        out[bufIndex++] = b64_index_table[((in[1] & 0x0f) << 2) | (in[2] >> 6)];
-        out[bufIndex++] = b64_index_table[in[2] & 0x3f];
-
-        encodedCount += 4;
-
-        if (encodedCount == BASE64_CHUNKED_LEN)
+        while (true)
         {
-            if (bufIndex + 1 < chunkSize)
+            chunk.len = encodeChunk(data_info, raw, buf[0], base64);
+
+            if (chunk.len <= 0)
             {
-                out[bufIndex++] = 0x0d;
-                out[bufIndex++] = 0x0a;
+                ret = chunk.len == 0;
+                break;
             }
-            encodedCount = 0;
-        }
 
-        dataReady = bufIndex >= chunkSize - 4;
-    }
-    else
-    {
-        memcpy(out + bufIndex, in, size);
-        bufIndex += size;
+            if (!sendBDAT(smtp, msg, chunk.len, false))
+                break;
 
-        if (bufIndex + 1 == BASE64_CHUNKED_LEN)
-        {
-            if (bufIndex + 2 < chunkSize)
-            {
-                out[bufIndex++] = 0x0d;
-                out[bufIndex++] = 0x0a;
-            }
+            if (!altSendData(buf[0], chunk.len, smtp, msg, false, false, esp_mail_smtp_cmd_undefined, esp_mail_smtp_status_code_0, SMTP_STATUS_UNDEFINED))
+                break;
+
+#if defined(ESP_MAIL_USE_ATTACHMENT_CACHE)
+            if (cacheWrite)
+                cacheWrite = mbfs->writeCache(buf[0], chunk.len) == chunk.len;
+#endif
+
+            if (report && data_info.size > 0)
+                uploadReport(data_info.filename, addr, 100 * data_info.dataIndex / data_info.size);
         }
+    }
+
+    if (chunk.len < 0)
+        errorStatusCB(smtp, MB_FS_ERROR_FILE_IO_ERROR);
 
-        dataReady = bufIndex + 1 >= chunkSize - size;
+#if defined(ESP_MAIL_USE_ATTACHMENT_CACHE)
+    if (cacheFile.length() > 0)
+    {
+        mbfs->closeCache();
+
+        // Remove the incomplete cache file
+        if (!ret || !cacheWrite)
+            mbfs->remove(cacheFile, mbfs_flash);
     }
+
+ex:
+#endif
+
+    closeChunk(data_info);
+
+    if (ret && report)
+        uploadReport(data_info.filename, addr, 100);
+
+    delP(&buf[0]);
+    delP(&buf[1]);
+    delP(&raw);
+
+    return ret;
 }
 
 MB_FS *ESP_Mail_Client::getMBFS()
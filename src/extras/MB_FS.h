@@ -712,6 +712,71 @@ public:
         return "";
     }
 
+    // Get last write time of opened file, 0 if not available.
+    time_t lastWrite(mbfs_file_type type)
+    {
+#if defined(MBFS_FLASH_FS)
+        if (type == mbfs_flash && mb_flashFs)
+            return mb_flashFs.getLastWrite();
+#endif
+#if defined(MBFS_SD_FS) && (defined(ESP32) || defined(ESP8266)) && !defined(MBFS_ESP32_SDFAT_ENABLED)
+        if (type == mbfs_sd && mb_sdFs)
+            return mb_sdFs.getLastWrite();
+#endif
+        return 0;
+    }
+
+#if defined(MBFS_FLASH_FS)
+
+    // Open cache file in flash for read or write, it can be opened along with other flash file.
+    // return size of file (read) or 0 (write) or negative value for error
+    int openCache(const MB_String &filename, mb_fs_open_mode mode)
+    {
+        closeCache();
+
+        if (!checkStorageReady(mbfs_flash))
+            return MB_FS_ERROR_FLASH_STORAGE_IS_NOT_READY;
+
+        if (mode == mb_fs_open_mode_read)
+        {
+            if (!existed(filename, mbfs_flash))
+                return MB_FS_ERROR_FILE_NOT_FOUND;
+
+            mb_cacheFs = MBFS_FLASH_FS.open(filename.c_str(), "r");
+            return mb_cacheFs ? mb_cacheFs.size() : MB_FS_ERROR_FILE_IO_ERROR;
+        }
+        else if (mode == mb_fs_open_mode_write)
+        {
+            remove(filename, mbfs_flash);
+            createDirs(filename, mbfs_flash);
+            mb_cacheFs = MBFS_FLASH_FS.open(filename.c_str(), "w");
+            return mb_cacheFs ? 0 : MB_FS_ERROR_FILE_IO_ERROR;
+        }
+
+        return MB_FS_ERROR_FILE_IO_ERROR;
+    }
+
+    // Read byte array from cache file. Return the number of bytes that completed read or negative value for error.
+    int readCache(uint8_t *buf, size_t len)
+    {
+        return mb_cacheFs ? mb_cacheFs.read(buf, len) : MB_FS_ERROR_FILE_IO_ERROR;
+    }
+
+    // Write byte array to cache file. Return the number of bytes that completed write or negative value for error.
+    int writeCache(const uint8_t *buf, size_t len)
+    {
+        return mb_cacheFs ? mb_cacheFs.write(buf, len) : MB_FS_ERROR_FILE_IO_ERROR;
+    }
+
+    // Close cache file.
+    void closeCache()
+    {
+        if (mb_cacheFs)
+            mb_cacheFs.close();
+    }
+
+#endif
+
     // Calculate CRC16 of byte array.
     uint16_t calCRC(const char *buf)
     {
@@ -740,8 +805,8 @@ public:
         }
     }
 
-    // Allocate memory
-    void *newP(size_t len)
+    // Allocate memory, the memory is zero filled unless clear is false
+    void *newP(size_t len, bool clear = true)
     {
         void *p;
         size_t newLen = getReservedLen(len);
@@ -772,7 +837,8 @@ public:
             return NULL;
 
 #endif
-        memset(p, 0, newLen);
+        if (clear)
+            memset(p, 0, newLen);
         return p;
     }
 
@@ -867,6 +933,7 @@ private:
 
 #if defined(MBFS_FLASH_FS)
     fs::File mb_flashFs;
+    fs::File mb_cacheFs;
 #endif
 #if defined(MBFS_SD_FS)
     MBFS_SD_FILE mb_sdFs;
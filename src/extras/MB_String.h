@@ -1,11 +1,19 @@
 
 /**
- * Mobizt's SRAM/PSRAM supported String, version 1.2.6
+ * Mobizt's SRAM/PSRAM supported String, version 1.2.7
  *
  * Created May 18, 2022
  *
  * Changes Log
  * 
+ * v1.2.7
+ * - Add MB_Arena, the bump allocator for short lived strings
+ * - Add move constructor, move assignment and swap
+ * - Store short strings inline without heap allocation (MB_STRING_SSO_SIZE)
+ * - Grow the buffer geometrically (MB_STRING_GROWTH_PERCENT, MB_STRING_GROWTH_MAX)
+ * - Add capacity() and make reserve() keep the current content
+ * - Keep the buffer when realloc fails
+ *
  * v1.2.6
  * - Update trim() function
  *
@@ -77,7 +85,17 @@
 
 #define MB_STRING_MAJOR 1
 #define MB_STRING_MINOR 2
-#define MB_STRING_PATCH 5
+#define MB_STRING_PATCH 7
+
+// The capacity in percent of the current capacity to grow to when the string needs more space
+#if !defined(MB_STRING_GROWTH_PERCENT)
+#define MB_STRING_GROWTH_PERCENT 200
+#endif
+
+// The maximum bytes to reserve more than the requested length in one growth
+#if !defined(MB_STRING_GROWTH_MAX)
+#define MB_STRING_GROWTH_MAX 4096
+#endif
 
 #if defined(ESP8266) && defined(MMU_EXTERNAL_HEAP) && defined(MB_STRING_USE_PSRAM)
 #include <umm_malloc/umm_malloc.h>
@@ -85,6 +103,20 @@
 #define ESP8266_USE_EXTERNAL_HEAP
 #endif
 
+// The default block size of MB_Arena
+#if !defined(MB_ARENA_BLOCK_SIZE)
+#define MB_ARENA_BLOCK_SIZE 1024
+#endif
+
+// The inline buffer size for short strings which are stored without heap allocation, 0 to disable
+#if !defined(MB_STRING_SSO_SIZE)
+#if defined(ESP8266_USE_EXTERNAL_HEAP)
+#define MB_STRING_SSO_SIZE 0
+#else
+#define MB_STRING_SSO_SIZE 16
+#endif
+#endif
+
 #if defined(ESP8266) || defined(ESP32)
 #define MBSTRING_FLASH_MCR FPSTR
 #elif defined(ARDUINO_ARCH_SAMD) || defined(__AVR_ATmega4809__) || defined(ARDUINO_NANO_RP2040_CONNECT)
@@ -468,6 +500,150 @@ namespace mb_string
 
 using namespace mb_string;
 
+// The active arena is kept per task for ESP32 which strings can be allocated from other tasks
+#if defined(ESP32)
+#define MB_ARENA_THREAD_LOCAL thread_local
+#else
+#define MB_ARENA_THREAD_LOCAL
+#endif
+
+/**
+ * The bump allocator for strings that are freed all together.
+ *
+ * While the arena is active (MB_ArenaScope) in the calling task, MB_String buffers that allocated
+ * by this task are taken from the arena blocks.
+ * Freeing an arena buffer does nothing, the memory is reclaimed by reset() in one shot.
+ * All strings using the arena buffers should be cleared before reset().
+ */
+class MB_Arena
+{
+public:
+    MB_Arena(size_t blockSize = MB_ARENA_BLOCK_SIZE)
+    {
+        this->blockSize = blockSize;
+    }
+
+    ~MB_Arena()
+    {
+        release();
+        if (current() == this)
+            current() = NULL;
+    }
+
+    // The arena owns its blocks, it cannot be copied
+    MB_Arena(const MB_Arena &) = delete;
+    MB_Arena &operator=(const MB_Arena &) = delete;
+
+    void *alloc(size_t len)
+    {
+        len = (len + 3) & ~(size_t)3;
+
+        if (!head || head->used + len > head->size)
+        {
+            size_t size = len > blockSize ? len : blockSize;
+            block_t *b = NULL;
+#if defined(BOARD_HAS_PSRAM) && defined(MB_STRING_USE_PSRAM)
+            if (ESP.getPsramSize() > 0)
+                b = (block_t *)ps_malloc(sizeof(block_t) + size);
+            else
+                b = (block_t *)malloc(sizeof(block_t) + size);
+#else
+            b = (block_t *)malloc(sizeof(block_t) + size);
+#endif
+            if (!b)
+                return NULL;
+            b->size = size;
+            b->used = 0;
+            b->next = head;
+            head = b;
+        }
+
+        void *p = (uint8_t *)(head + 1) + head->used;
+        head->used += len;
+        return p;
+    }
+
+    bool owns(const void *p) const
+    {
+        for (block_t *b = head; b; b = b->next)
+        {
+            if ((const uint8_t *)p >= (const uint8_t *)(b + 1) && (const uint8_t *)p < (const uint8_t *)(b + 1) + b->size)
+                return true;
+        }
+        return false;
+    }
+
+    // Reclaim all memory, keep the latest block for reuse
+    void reset()
+    {
+        if (!head)
+            return;
+        block_t *b = head->next;
+        while (b)
+        {
+            block_t *n = b->next;
+            free(b);
+            b = n;
+        }
+        head->next = NULL;
+        head->used = 0;
+    }
+
+    // Free all blocks
+    void release()
+    {
+        reset();
+        if (head)
+            free(head);
+        head = NULL;
+    }
+
+    size_t used() const
+    {
+        size_t n = 0;
+        for (block_t *b = head; b; b = b->next)
+            n += b->used;
+        return n;
+    }
+
+    // The arena that new string buffers of the calling task are allocated from
+    static MB_Arena *&current()
+    {
+        static MB_ARENA_THREAD_LOCAL MB_Arena *arena = NULL;
+        return arena;
+    }
+
+private:
+    struct block_t
+    {
+        block_t *next;
+        size_t size;
+        size_t used;
+    };
+
+    block_t *head = NULL;
+    size_t blockSize = MB_ARENA_BLOCK_SIZE;
+};
+
+// Use the arena for the string allocations in this scope
+class MB_ArenaScope
+{
+public:
+    MB_ArenaScope(MB_Arena *arena)
+    {
+        prev = MB_Arena::current();
+        MB_Arena::current() = arena;
+    }
+
+    ~MB_ArenaScope()
+    {
+        MB_Arena::current() = prev;
+    }
+
+private:
+    MB_Arena *prev = NULL;
+};
+
 class MB_String
 {
 public:
@@ -495,6 +671,13 @@ public:
         *this = value;
     }
 
+#if !defined(__AVR__)
+    MB_String(MB_String &&value) noexcept
+    {
+        move(value);
+    }
+#endif
+
     MB_String(const __FlashStringHelper *str)
     {
         *this = str;
@@ -678,6 +861,15 @@ public:
         return (*this);
     }
 
+#if !defined(__AVR__)
+    MB_String &operator=(MB_String &&rhs) noexcept
+    {
+        if (this != &rhs)
+            move(rhs);
+        return *this;
+    }
+#endif
+
     MB_String &operator=(const MB_String &rhs)
     {
         if (this == &rhs)
@@ -699,12 +891,15 @@ public:
 
     MB_String &operator+=(const char *cstr)
     {
+        if (!cstr)
+            return (*this);
+
         size_t len = strlen_P(cstr);
         size_t slen = length();
 
         if (_reserve(slen + len, false))
         {
-            strcat_P(buf, (PGM_P)cstr);
+            memcpy_P(buf + slen, (PGM_P)cstr, len);
             *(buf + slen + len) = '\0';
         }
 
@@ -965,8 +1160,9 @@ public:
 
         size_t slen = length();
 
-        if (n > strlen(cstr))
-            n = strlen(cstr);
+        const char *end = (const char *)memchr(cstr, 0, n);
+        if (end)
+            n = end - cstr;
 
         if (_reserve(slen + n, false))
         {
@@ -1040,7 +1236,12 @@ public:
 
     void swap(MB_String &rhs)
     {
-        rhs.clear();
+        if (this == &rhs)
+            return;
+        MB_String tmp;
+        tmp.move(rhs);
+        rhs.move(*this);
+        move(tmp);
     }
 
     void shrink_to_fit()
@@ -1056,7 +1257,6 @@ public:
             size_t slen = length();
             if (slen > 0)
                 buf[slen - 1] = '\0';
-            _reserve(slen, true);
         }
     }
 
@@ -1111,8 +1311,6 @@ public:
         memmove(buf + index, buf + index + len, rightLen);
 
         buf[index + rightLen] = '\0';
-
-        _reserve(length(), true);
     }
 
     size_t length() const
@@ -1413,8 +1611,14 @@ public:
 
     void reserve(size_t len)
     {
-        if (_reserve(len, false))
-            buf[len] = '\0';
+        size_t newlen = getReservedLen(len);
+        if (newlen > bufLen)
+            allocate(newlen, false);
+    }
+
+    size_t capacity() const
+    {
+        return maxLength();
     }
 
     static const size_t npos = -1;
@@ -1624,25 +1828,61 @@ private:
         concat(cstr, strlen(cstr));
     }
 
+    // Take over the rhs buffer, the rhs becomes empty
     void move(MB_String &rhs)
     {
-        if (buf)
+        allocate(0, false);
+
+#if MB_STRING_SSO_SIZE > 0
+        if (rhs.inlined())
         {
-            if (bufLen >= rhs.bufLen)
-            {
-                strcpy(buf, rhs.buf);
-                bufLen = rhs.bufLen;
-                rhs.bufLen = 0;
-                return;
-            }
-            else
-            {
-                free(buf);
-            }
+            memcpy(sso, rhs.sso, MB_STRING_SSO_SIZE);
+            buf = sso;
         }
-        buf = rhs.buf;
+        else
+#endif
+            buf = rhs.buf;
+
         bufLen = rhs.bufLen;
+        arenaBuf = rhs.arenaBuf;
         rhs.buf = NULL;
+        rhs.bufLen = 0;
+        rhs.arenaBuf = false;
+    }
+
+    bool inlined() const
+    {
+#if MB_STRING_SSO_SIZE > 0
+        return buf == sso;
+#else
+        return false;
+#endif
+    }
+
+    // Allocate the buffer from the active arena or heap
+    char *newBuf(size_t len, bool &arena)
+    {
+        arena = false;
+#if !defined(ESP8266_USE_EXTERNAL_HEAP)
+        if (MB_Arena::current())
+        {
+            arena = true;
+            return (char *)MB_Arena::current()->alloc(len);
+        }
+#endif
+#if defined(BOARD_HAS_PSRAM) && defined(MB_STRING_USE_PSRAM)
+        if (ESP.getPsramSize() > 0)
+            return (char *)ps_malloc(len);
+#endif
+        return (char *)malloc(len);
+    }
+
+    // Free the heap buffer, the arena buffer is reclaimed by the arena reset
+    void freeBuf(char *p)
+    {
+        if (!arenaBuf)
+            free(p);
+        arenaBuf = false;
     }
 
     void allocate(size_t len, bool shrink)
@@ -1650,8 +1890,8 @@ private:
 
         if (len == 0)
         {
-            if (buf)
-                free(buf);
+            if (buf && !inlined())
+                freeBuf(buf);
             buf = NULL;
             bufLen = 0;
             return;
@@ -1660,38 +1900,79 @@ private:
         if (len > bufLen || shrink)
         {
 
+#if MB_STRING_SSO_SIZE > 0
+            // short string fits in the inline buffer
+            if (len <= MB_STRING_SSO_SIZE)
+            {
+                if (!inlined())
+                {
+                    size_t slen = length();
+                    if (slen >= MB_STRING_SSO_SIZE)
+                        slen = MB_STRING_SSO_SIZE - 1;
+                    if (buf)
+                    {
+                        memcpy(sso, buf, slen);
+                        freeBuf(buf);
+                    }
+                    sso[slen] = '\0';
+                    buf = sso;
+                }
+                bufLen = MB_STRING_SSO_SIZE;
+                return;
+            }
+#endif
+
 #if defined(ESP8266_USE_EXTERNAL_HEAP)
             ESP.setExternalHeap();
 #endif
 
-            if (shrink || (bufLen > 0 && buf))
+            if (arenaBuf && len <= bufLen)
+            {
+                // no need to shrink the arena buffer
+                buf[len - 1] = '\0';
+            }
+            else if (inlined() || arenaBuf)
+            {
+                // the inline and arena buffers cannot be reallocated
+                bool arena = false;
+                char *p = newBuf(len, arena);
+                if (p)
+                {
+                    size_t slen = length();
+                    if (slen >= len)
+                        slen = len - 1;
+                    memcpy(p, buf, slen);
+                    p[slen] = '\0';
+                    buf = p;
+                    bufLen = len;
+                    arenaBuf = arena;
+                }
+            }
+            else if (shrink || (bufLen > 0 && buf))
             {
                 int slen = length();
 
+                char *p = NULL;
 #if defined(BOARD_HAS_PSRAM) && defined(MB_STRING_USE_PSRAM)
                 if (ESP.getPsramSize() > 0)
-                    buf = (char *)ps_realloc(buf, len);
+                    p = (char *)ps_realloc(buf, len);
                 else
-                    buf = (char *)realloc(buf, len);
+                    p = (char *)realloc(buf, len);
 #else
-                buf = (char *)realloc(buf, len);
+                p = (char *)realloc(buf, len);
 #endif
-                if (buf)
+                if (p)
                 {
+                    buf = p;
+                    if ((size_t)slen >= len)
+                        slen = len - 1;
                     buf[slen] = '\0';
                     bufLen = len;
                 }
             }
             else
             {
-#if defined(BOARD_HAS_PSRAM) && defined(MB_STRING_USE_PSRAM)
-                if (ESP.getPsramSize() > 0)
-                    buf = (char *)ps_malloc(len);
-                else
-                    buf = (char *)malloc(len);
-#else
-                buf = (char *)malloc(len);
-#endif
+                buf = newBuf(len, arenaBuf);
                 if (buf)
                 {
                     buf[0] = '\0';
@@ -1728,7 +2009,21 @@ private:
         if (shrink)
             allocate(newlen, true);
         else if (newlen > bufLen)
-            allocate(newlen, false);
+        {
+            // grow geometrically to avoid the realloc and copy in every append
+            if (bufLen > 0)
+            {
+                size_t growLen = bufLen * MB_STRING_GROWTH_PERCENT / 100;
+                if (growLen > newlen + MB_STRING_GROWTH_MAX)
+                    growLen = newlen + MB_STRING_GROWTH_MAX;
+                if (growLen > newlen)
+                    allocate(getReservedLen(growLen), false);
+            }
+
+            // fall back to the exact length when the larger block is not available
+            if (newlen > bufLen)
+                allocate(newlen, false);
+        }
 
         return newlen <= bufLen;
     }
@@ -1974,6 +2269,11 @@ private:
 
     char *buf = NULL;
     size_t bufLen = 0;
+    // The buffer was allocated from the arena
+    bool arenaBuf = false;
+#if MB_STRING_SSO_SIZE > 0
+    char sso[MB_STRING_SSO_SIZE];
+#endif
 };
 
 inline MB_String operator+(const MB_String &lhs, const MB_String &rhs)
@@ -6,177 +6,179 @@
 RFC2047_Decoder::RFC2047_Decoder() {}
 RFC2047_Decoder::~RFC2047_Decoder() {}
 
-void RFC2047_Decoder::decode(MB_FS *mbfs, char *d, const char *s, size_t dlen)
+void RFC2047_Decoder::decode(MB_String &out, const char *s, size_t len, RFC2047_CharsetConverter conv, void *arg)
 {
-  if (!mbfs)
+  if (!s)
     return;
 
-  this->mbfs = mbfs;
+  const char *end = s + len;
+  const char *text = s;
+  bool found_encoded = false;
 
-  const char *p, *q;
-  size_t n;
-  int found_encoded = 0;
+  out.reserve(out.length() + len);
 
-  dlen--; /* save room for the terminal nul */
-
-  while (*s && dlen > 0)
+  while (s < end)
   {
-    if ((p = strstr(s, "=?")) == NULL ||
-        (q = strchr(p + 2, '?')) == NULL ||
-        (q = strchr(q + 1, '?')) == NULL ||
-        (q = strstr(q + 1, "?=")) == NULL)
+    const char *p = (const char *)memchr(s, '=', end - s);
+    if (!p)
+      break;
+
+    if (p + 1 >= end || p[1] != '?')
     {
-      /* no encoded words */
-      if (d != s)
-        strfcpy(d, s, dlen + 1);
-      return;
+      s = p + 1;
+      continue;
     }
 
-    if (p != s)
+    /* =?charset?encoding?encoded-text?= */
+    const char *q = (const char *)memchr(p + 2, '?', end - p - 2);
+    if (q)
+      q = (const char *)memchr(q + 1, '?', end - q - 1);
+    const char *e = q ? q + 1 : nullptr;
+    while (e && e + 1 < end && !(e[0] == '?' && e[1] == '='))
+      e++;
+
+    if (!e || e + 1 >= end)
+      break;
+
+    /* ignore spaces between encoded words, they are kept when this word is not decoded */
+    size_t n = p - text;
+    bool space = found_encoded;
+    for (size_t i = 0; i < n && space; i++)
+      space = text[i] == ' ' || text[i] == '\t' || text[i] == '\r' || text[i] == '\n';
+
+    if (!space)
+      out.append(text, n);
+
+    /* decodeWord writes nothing when the word is invalid */
+    if (decodeWord(out, p, e, conv, arg))
     {
-      n = (size_t)(p - s);
-      /* ignore spaces between encoded words */
-      if (!found_encoded || strspn(s, " \t\r\n") != n)
-      {
-        if (n > dlen)
-          n = dlen;
-        if (d != s)
-          memcpy(d, s, n);
-        d += n;
-        dlen -= n;
-      }
+      found_encoded = true;
+      s = text = e + 2;
+      continue;
     }
 
-    rfc2047DecodeWord(d, p, dlen);
-    found_encoded = 1;
-    s = q + 2;
-    n = strlen(d);
-    dlen -= n;
-    d += n;
+    /* keep the stray "=?" as text and look for the next encoded word after it */
+    if (space)
+      out.append(text, n);
+    out.append(p, 2);
+
+    found_encoded = false;
+    s = text = p + 2;
   }
-  *d = 0;
+
+  if (text < end)
+    out.append(text, end - text);
 }
 
-void RFC2047_Decoder::rfc2047DecodeWord(char *d, const char *s, size_t dlen)
+bool RFC2047_Decoder::decodeWord(MB_String &out, const char *s, const char *end, RFC2047_CharsetConverter conv, void *arg)
 {
-
-  if (!mbfs)
-    return;
-
-  char *p = safe_strdup(s);
-  char *pp = p;
-  char *pd = d;
-  size_t len = dlen;
-  int enc = 0, filter = 0, count = 0, c1, c2, c3, c4;
-
-  while ((pp = strtok(pp, "?")) != NULL)
+  // s points to "=?" and end points to the closing "?="
+  const char *charset = s + 2;
+  const char *q = (const char *)memchr(charset, '?', end - charset);
+  if (!q || q + 2 >= end || q[2] != '?')
+    return false;
+
+  size_t charsetLen = q - charset;
+  int enc = 0;
+
+  if (toupper(q[1]) == 'Q')
+    enc = ENCQUOTEDPRINTABLE;
+  else if (toupper(q[1]) == 'B')
+    enc = ENCBASE64;
+  else
+    return false;
+
+  // The language suffix (rfc 2231) is not the part of charset name
+  const char *lang = (const char *)memchr(charset, '*', charsetLen);
+  if (lang)
+    charsetLen = lang - charset;
+
+  bool filter = charsetLen != strlen(Charset) || strncasecmp(charset, Charset, charsetLen) != 0;
+
+  const char *pp = q + 3;
+  char buf[RFC2047_CHUNK_SIZE];
+  size_t n = 0;
+
+  if (enc == ENCQUOTEDPRINTABLE)
   {
-    count++;
-    switch (count)
+    while (pp < end)
     {
-    case 2:
-      if (strcasecmp(pp, Charset) != 0)
-      {
-        filter = 1;
-      }
-      break;
-    case 3:
-      if (toupper(*pp) == 'Q')
-        enc = ENCQUOTEDPRINTABLE;
-      else if (toupper(*pp) == 'B')
-        enc = ENCBASE64;
-      else
-        return;
-      break;
-    case 4:
-      if (enc == ENCQUOTEDPRINTABLE)
+      if (n + 1 > sizeof(buf))
       {
-        while (*pp && len > 0)
-        {
-          if (*pp == '_')
-          {
-            *pd++ = ' ';
-            len--;
-          }
-          else if (*pp == '=')
-          {
-            *pd++ = (hexval(pp[1]) << 4) | hexval(pp[2]);
-            len--;
-            pp += 2;
-          }
-          else
-          {
-            *pd++ = *pp;
-            len--;
-          }
-          pp++;
-        }
-        *pd = 0;
+        flush(out, charset, charsetLen, buf, n, filter, conv, arg);
+        n = 0;
       }
-      else if (enc == ENCBASE64)
+
+      if (*pp == '_')
+        buf[n++] = ' ';
+      else if (*pp == '=' && pp + 2 < end && hexval(pp[1]) >= 0 && hexval(pp[2]) >= 0)
       {
-        while (*pp && len > 0)
-        {
-          c1 = base64val(pp[0]);
-          c2 = base64val(pp[1]);
-          *pd++ = (c1 << 2) | ((c2 >> 4) & 0x3);
-          if (--len == 0)
-            break;
-
-          if (pp[2] == '=')
-            break;
-
-          c3 = base64val(pp[2]);
-          *pd++ = ((c2 & 0xf) << 4) | ((c3 >> 2) & 0xf);
-          if (--len == 0)
-            break;
-
-          if (pp[3] == '=')
-            break;
-
-          c4 = base64val(pp[3]);
-          *pd++ = ((c3 & 0x3) << 6) | c4;
-          if (--len == 0)
-            break;
-
-          pp += 4;
-        }
-        *pd = 0;
+        buf[n++] = (hexval(pp[1]) << 4) | hexval(pp[2]);
+        pp += 2;
       }
-      break;
+      else
+        buf[n++] = *pp;
+      pp++;
     }
-    pp = 0;
   }
-  mbfs->delP(&p);
-  if (filter)
+  else
   {
-
-    pd = d;
-    while (*pd)
+    while (pp + 1 < end)
     {
-      if (!IsPrint(*pd))
-        *pd = '?';
-      pd++;
+      if (n + 3 > sizeof(buf))
+      {
+        flush(out, charset, charsetLen, buf, n, filter, conv, arg);
+        n = 0;
+      }
+
+      int c1 = base64val(pp[0]), c2 = base64val(pp[1]);
+      if (c1 < 0 || c2 < 0)
+        break;
+
+      buf[n++] = (c1 << 2) | ((c2 >> 4) & 0x3);
+
+      if (pp + 2 >= end || pp[2] == '=')
+        break;
+
+      int c3 = base64val(pp[2]);
+      if (c3 < 0)
+        break;
+
+      buf[n++] = ((c2 & 0xf) << 4) | ((c3 >> 2) & 0xf);
+
+      if (pp + 3 >= end || pp[3] == '=')
+        break;
+
+      int c4 = base64val(pp[3]);
+      if (c4 < 0)
+        break;
+
+      buf[n++] = ((c3 & 0x3) << 6) | c4;
+      pp += 4;
     }
   }
-  return;
+
+  flush(out, charset, charsetLen, buf, n, filter, conv, arg);
+
+  return true;
 }
 
-char *RFC2047_Decoder::safe_strdup(const char *s)
+void RFC2047_Decoder::flush(MB_String &out, const char *charset, size_t charsetLen, char *buf, size_t len, bool filter, RFC2047_CharsetConverter conv, void *arg)
 {
-  
-  if (!mbfs)
-    return 0;
-
-  char *p;
-  size_t l;
-
-  if (!s || !*s)
-    return 0;
-  l = strlen(s) + 1;
-  p = (char *)mbfs->newP(l);
-  memcpy(p, s, l);
-  return (p);
+  if (len == 0)
+    return;
+
+  for (size_t i = 0; i < len; i++)
+  {
+    // The null byte ends the string, the 8-bit bytes are left to the charset converter
+    if (buf[i] == 0 || (filter && (conv ? iscntrl((unsigned char)buf[i]) : !IsPrint(buf[i]))))
+      buf[i] = '?';
+  }
+
+  if (conv)
+    conv(arg, out, charset, charsetLen, buf, len);
+  else
+    out.append(buf, len);
 }
 
-#endif // RFC2047_CPP
\ No newline at end of file
+#endif // RFC2047_CPP
@@ -50,8 +50,14 @@ __attribute__((used)) static int Index_64[128] = {
 #define IsPrint(c) (isprint((unsigned char)(c)) || \
                     ((unsigned char)(c) >= 0xa0))
 
-#define hexval(c) Index_hex[(unsigned int)(c)]
-#define base64val(c) Index_64[(unsigned int)(c)]
+#define hexval(c) ((unsigned char)(c) < 128 ? Index_hex[(unsigned char)(c)] : -1)
+#define base64val(c) ((unsigned char)(c) < 128 ? Index_64[(unsigned char)(c)] : -1)
+
+// The decoded bytes are collected in this size of stack buffer before appending to the output
+#define RFC2047_CHUNK_SIZE 64
+
+// The decoded data chunk of encoded word is passed to this function to convert from its charset and append to out
+typedef void (*RFC2047_CharsetConverter)(void *arg, MB_String &out, const char *charset, size_t charsetLen, const char *data, size_t len);
 
 class RFC2047_Decoder
 {
@@ -59,12 +65,15 @@ class RFC2047_Decoder
 public:
     RFC2047_Decoder();
     ~RFC2047_Decoder();
-    void decode(MB_FS *mbfs, char *d, const char *s, size_t dlen);
+
+    // Decode the encoded words in s and append the result to out.
+    // The white space between adjacent encoded words is removed.
+    // The decoded data is converted by conv when it was set.
+    void decode(MB_String &out, const char *s, size_t len, RFC2047_CharsetConverter conv = nullptr, void *arg = nullptr);
 
 private:
-    void rfc2047DecodeWord(char *d, const char *s, size_t dlen);
-    char *safe_strdup(const char *s);
-    MB_FS *mbfs = nullptr;
+    bool decodeWord(MB_String &out, const char *s, const char *end, RFC2047_CharsetConverter conv, void *arg);
+    void flush(MB_String &out, const char *charset, size_t charsetLen, char *buf, size_t len, bool filter, RFC2047_CharsetConverter conv, void *arg);
 };
 
 #endif // RFC2047_H
\ No newline at end of file
@@ -26,12 +26,14 @@
 
 #include "esp32/ESP32_TCP_Client.h"
 #define ESP_MAIL_TCP_CLIENT ESP32_TCP_Client
+#define ESP_MAIL_TLS_SESSION_CACHE ESP32_SSL_Client::session_cache
 
 #elif defined(ESP8266)
 
 #include <ESP8266WiFi.h>
 #include "esp8266/ESP8266_TCP_Client.h"
 #define ESP_MAIL_TCP_CLIENT ESP8266_TCP_Client
+#define ESP_MAIL_TLS_SESSION_CACHE ESP8266_WCS::session_cache
 
 #elif defined(MB_MCU_ATMEL_ARM) && !defined(ARDUINO_SAMD_MKR1000) || defined(MB_MCU_RP2040)
 
@@ -117,6 +117,42 @@ public:
 
     virtual int hostByName(const char *name, IPAddress &ip) { return 0; }
 
+    /* Resolve the host name or use the address that was resolved within the DNS cache TTL */
+    int cachedHostByName(const char *name, IPAddress &ip)
+    {
+        if (dnsTTL > 0 && dnsIP != 0 && strcmp(dnsHost.c_str(), name) == 0 && millis() - dnsMillis < dnsTTL)
+        {
+            ip = dnsIP;
+            return 1;
+        }
+
+        int ret = hostByName(name, ip);
+
+        if (ret == 1)
+        {
+            dnsHost = name;
+            dnsIP = (uint32_t)ip;
+            dnsMillis = millis();
+        }
+        else
+            clearDNSCache();
+
+        return ret;
+    }
+
+    /* Remove the cached address e.g. when the connection to it was failed */
+    void clearDNSCache()
+    {
+        dnsHost.clear();
+        dnsIP = 0;
+    }
+
+    /* Set the DNS cache TTL in ms, 0 for no cache */
+    void setDNSCacheTTL(uint32_t ttl) { dnsTTL = ttl; }
+
+    /* Keep the received data when sending, e.g. the responses of the pipelined commands that are not read yet */
+    void setKeepReceivedData(bool keep) { keepRxData = keep; }
+
     virtual bool begin(const char *host, uint16_t port)
     {
         this->host = host;
@@ -190,6 +226,11 @@ protected:
     int tmo = 40000; // 40 sec
     bool clockReady = false;
     time_t now = 0;
+    MB_String dnsHost;
+    uint32_t dnsIP = 0;
+    unsigned long dnsMillis = 0;
+    uint32_t dnsTTL = ESP_MAIL_DNS_CACHE_TTL;
+    bool keepRxData = false;
 #if defined(ENABLE_IMAP) || defined(ENABLE_SMTP)
     ESP_Mail_Session *session = nullptr;
 #endif
@@ -0,0 +1,220 @@
+/*
+ * TLS Session Cache class, version 1.0.0
+ *
+ * October 18, 2026
+ *
+ * The MIT License (MIT)
+ * Copyright (c) 2022 K. Suwatchai (Mobizt)
+ *
+ *
+ * Permission is hereby granted, free of charge, to any person returning a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef TLS_SESSION_CACHE_H
+#define TLS_SESSION_CACHE_H
+
+#include <Arduino.h>
+#include "ESP_Mail_Const.h"
+
+#if defined(ESP_MAIL_USE_TLS_SESSION_CACHE)
+
+typedef struct tls_session_cache_stats_t
+{
+    // The number of completed TLS handshakes
+    uint32_t handshakes = 0;
+    // The number of handshakes that offered the cached session
+    uint32_t offered = 0;
+    // The number of abbreviated handshakes that resumed the cached session
+    uint32_t resumed = 0;
+    // The number of sessions that were removed from the full cache
+    uint32_t evicted = 0;
+} TLS_Session_Cache_Stats;
+
+/* The TLS sessions of the recently connected servers which shared by all clients.
+ * The session type T is the TLS library session that is freed by its destructor.
+ * The number of sessions is limited by ESP_MAIL_TLS_SESSION_CACHE_SIZE and
+ * the session is valid for ESP_MAIL_TLS_SESSION_CACHE_TTL ms after its full handshake.
+ * The cached sessions are only accessed inside the callback functions while the cache is locked
+ * because the clients in other tasks (ESP32) can remove them at any time.
+ */
+template <typename T>
+class TLS_Session_Cache
+{
+public:
+    /* Call fn(T &) with the cached session of server host and port.
+     * Return false when the session was not found, expired or fn returned false.
+     */
+    template <typename F>
+    static bool get(const char *host, uint16_t port, bool verify, F fn)
+    {
+        lock();
+
+        bool ret = false;
+        int index = find(host, port, verify);
+
+        if (index > -1 && millis() - items()[index].ts >= ESP_MAIL_TLS_SESSION_CACHE_TTL)
+            erase(index);
+        else if (index > -1)
+            ret = fn(*items()[index].session);
+
+        unlock();
+        return ret;
+    }
+
+    /* Call fn(T &) with the new empty session of server host and port to store the session of current connection.
+     * The session is removed when fn returned false.
+     * The resumed session keeps the expiry time of the session that it was resumed from.
+     */
+    template <typename F>
+    static bool add(const char *host, uint16_t port, bool verify, bool resumed, F fn)
+    {
+        if (ESP_MAIL_TLS_SESSION_CACHE_SIZE == 0)
+            return false;
+
+        lock();
+
+        unsigned long ts = millis();
+
+        int index = find(host, port, verify);
+        if (index > -1)
+        {
+            if (resumed)
+                ts = items()[index].ts;
+            erase(index);
+        }
+        else if (items().size() >= ESP_MAIL_TLS_SESSION_CACHE_SIZE)
+        {
+            // remove the oldest session
+            erase(0);
+            counters().evicted++;
+        }
+
+        item_t item;
+        item.host = host;
+        item.port = port;
+        item.verify = verify;
+        item.ts = ts;
+        item.session = new T();
+        items().push_back(item);
+
+        bool ret = fn(*item.session);
+        if (!ret)
+            erase(items().size() - 1);
+
+        unlock();
+        return ret;
+    }
+
+    /* Remove the cached session of server host and port e.g. when the server rejected it */
+    static void remove(const char *host, uint16_t port, bool verify)
+    {
+        lock();
+        int index = find(host, port, verify);
+        if (index > -1)
+            erase(index);
+        unlock();
+    }
+
+    /* Remove all cached sessions */
+    static void clear()
+    {
+        lock();
+        for (size_t i = 0; i < items().size(); i++)
+            delete items()[i].session;
+        items().clear();
+        unlock();
+    }
+
+    /* Count the completed handshake */
+    static void addHandshake(bool offered, bool resumed)
+    {
+        lock();
+        counters().handshakes++;
+        if (offered)
+            counters().offered++;
+        if (resumed)
+            counters().resumed++;
+        unlock();
+    }
+
+    static TLS_Session_Cache_Stats stats()
+    {
+        lock();
+        TLS_Session_Cache_Stats ret = counters();
+        unlock();
+        return ret;
+    }
+
+private:
+    typedef struct item_t
+    {
+        MB_String host;
+        uint16_t port = 0;
+        bool verify = false;
+        unsigned long ts = 0;
+        T *session = nullptr;
+    } item_t;
+
+    static std::vector<item_t> &items()
+    {
+        static std::vector<item_t> _items;
+        return _items;
+    }
+
+    static TLS_Session_Cache_Stats &counters()
+    {
+        static TLS_Session_Cache_Stats _stats;
+        return _stats;
+    }
+
+#if defined(ESP32)
+    static SemaphoreHandle_t mutex()
+    {
+        static SemaphoreHandle_t _mutex = xSemaphoreCreateMutex();
+        return _mutex;
+    }
+
+    static void lock() { xSemaphoreTake(mutex(), portMAX_DELAY); }
+
+    static void unlock() { xSemaphoreGive(mutex()); }
+#else
+    static void lock() {}
+
+    static void unlock() {}
+#endif
+
+    static int find(const char *host, uint16_t port, bool verify)
+    {
+        for (size_t i = 0; i < items().size(); i++)
+        {
+            if (items()[i].port == port && items()[i].verify == verify && strcmp(items()[i].host.c_str(), host) == 0)
+                return i;
+        }
+        return -1;
+    }
+
+    static void erase(int index)
+    {
+        delete items()[index].session;
+        items().erase(items().begin() + index);
+    }
+};
+
+#endif
+
+#endif // TLS_SESSION_CACHE_H
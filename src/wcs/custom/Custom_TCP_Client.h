@@ -147,7 +147,8 @@ public:
     {
         if (connected())
         {
-            flush();
+            if (!keepRxData)
+                flush();
             return true;
         }
 
@@ -83,7 +83,7 @@ void ESP32_SSL_Client::ssl_init(ssl_data *ssl)
     mbedtls_ctr_drbg_init(&ssl->drbg_ctx);
 }
 
-int ESP32_SSL_Client::start_tcp_connection(ssl_data *ssl, const char *host, uint32_t port, int timeout)
+int ESP32_SSL_Client::start_tcp_connection(ssl_data *ssl, const char *host, uint32_t port, int timeout, uint32_t ip)
 {
 
     int enable = 1;
@@ -95,6 +95,7 @@ int ESP32_SSL_Client::start_tcp_connection(ssl_data *ssl, const char *host, uint
 
     log_v("Starting socket");
     ssl->socket = -1;
+    ssl->port = port;
 
     ssl->socket = lwip_socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
     if (ssl->socket < 0)
@@ -105,8 +106,8 @@ int ESP32_SSL_Client::start_tcp_connection(ssl_data *ssl, const char *host, uint
         return ssl->socket;
     }
 
-    IPAddress srv((uint32_t)0);
-    if (!WiFiGenericClass::hostByName(host, srv))
+    IPAddress srv(ip);
+    if (ip == 0 && !WiFiGenericClass::hostByName(host, srv))
     {
         if (ssl->_debugCallback)
             ssl_client_debug_pgm_send_cb(ssl, esp_ssl_client_str_4);
@@ -345,15 +346,28 @@ int ESP32_SSL_Client::connect_ssl(ssl_data *ssl, const char *host, const char *r
 
     mbedtls_ssl_set_bio(&ssl->ssl_ctx, &ssl->socket, mbedtls_net_send, mbedtls_net_recv, NULL);
 
+#if defined(ESP_MAIL_USE_TLS_SESSION_CACHE)
+    // Offer the cached session of this server for the abbreviated handshake
+    // The session is copied to the SSL context while the cache is locked
+    bool cached = session_cache::get(host, ssl->port, !insecure, [ssl](tls_session &s)
+                                     { return mbedtls_ssl_set_session(&ssl->ssl_ctx, &s.session) == 0; });
+#endif
+
     if (ssl->_debugCallback)
         ssl_client_debug_pgm_send_cb(ssl, esp_ssl_client_str_18);
 
     log_v("Performing the SSL/TLS handshake...");
+    bool full_handshake = false;
     unsigned long handshake_start_time = millis();
-    while ((ret = mbedtls_ssl_handshake(&ssl->ssl_ctx)) != 0)
+    while ((ret = ssl_handshake(ssl, full_handshake)) != 0)
     {
         if (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE)
         {
+#if defined(ESP_MAIL_USE_TLS_SESSION_CACHE)
+            // The server may not accept the cached session again
+            if (cached)
+                session_cache::remove(host, ssl->port, !insecure);
+#endif
             if (ssl->_debugCallback)
                 ssl_client_send_mbedtls_error_cb(ssl, ret);
             return esp32_ssl_handle_error(ret);
@@ -394,6 +408,16 @@ int ESP32_SSL_Client::connect_ssl(ssl_data *ssl, const char *host, const char *r
         log_v("Certificate verified.");
     }
 
+#if defined(ESP_MAIL_USE_TLS_SESSION_CACHE)
+    bool resumed = cached && !full_handshake;
+    session_cache::addHandshake(cached, resumed);
+    log_v("TLS session %s", resumed ? "resumed" : "created");
+
+    // Store the session (and its new ticket) for the next connection
+    session_cache::add(host, ssl->port, !insecure, resumed, [ssl](tls_session &s)
+                       { return mbedtls_ssl_get_session(&ssl->ssl_ctx, &s.session) == 0; });
+#endif
+
     if (rootCABuff != NULL)
     {
         mbedtls_x509_crt_free(&ssl->ca_cert);
@@ -414,6 +438,25 @@ int ESP32_SSL_Client::connect_ssl(ssl_data *ssl, const char *host, const char *r
     return ssl->socket;
 }
 
+int ESP32_SSL_Client::ssl_handshake(ssl_data *ssl, bool &full)
+{
+#if defined(ESP_MAIL_USE_TLS_SESSION_CACHE)
+    // Step through the handshake states as mbedtls_ssl_handshake does,
+    // the server certificate state is skipped when the session was resumed.
+    int ret = 0;
+    while (ret == 0 && ESP32_SSL_CTX_STATE(ssl) != MBEDTLS_SSL_HANDSHAKE_OVER)
+    {
+        if (ESP32_SSL_CTX_STATE(ssl) == MBEDTLS_SSL_SERVER_CERTIFICATE)
+            full = true;
+        ret = mbedtls_ssl_handshake_step(&ssl->ssl_ctx);
+    }
+    return ret;
+#else
+    full = true;
+    return mbedtls_ssl_handshake(&ssl->ssl_ctx);
+#endif
+}
+
 void ESP32_SSL_Client::stop_tcp_connection(ssl_data *ssl, const char *rootCABuff, const char *cli_cert, const char *cli_key)
 {
     if (ssl->_debugCallback)
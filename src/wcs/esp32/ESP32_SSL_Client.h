@@ -44,6 +44,13 @@
 #include "mbedtls/entropy.h"
 #include "mbedtls/ctr_drbg.h"
 #include "mbedtls/error.h"
+#include "./wcs/base/TLS_Session_Cache.h"
+
+#if defined(MBEDTLS_PRIVATE)
+#define ESP32_SSL_CTX_STATE(ssl) ((ssl)->ssl_ctx.MBEDTLS_PRIVATE(state))
+#else
+#define ESP32_SSL_CTX_STATE(ssl) ((ssl)->ssl_ctx.state)
+#endif
 
 static const char esp_ssl_client_str_1[] PROGMEM = "! E: ";
 static const char esp_ssl_client_str_2[] PROGMEM = "> C: starting socket";
@@ -99,8 +106,23 @@ public:
 
         // milliseconds SSL handshake time out
         unsigned long handshake_timeout;
+
+        // The server port that used as TLS session cache key
+        uint16_t port = 0;
     } ssl_data;
 
+#if defined(ESP_MAIL_USE_TLS_SESSION_CACHE)
+    // The cached TLS session
+    struct tls_session
+    {
+        tls_session() { mbedtls_ssl_session_init(&session); }
+        ~tls_session() { mbedtls_ssl_session_free(&session); }
+        mbedtls_ssl_session session;
+    };
+
+    typedef TLS_Session_Cache<tls_session> session_cache;
+#endif
+
     void ssl_init(ssl_data *ssl);
 
     /**
@@ -110,9 +132,10 @@ public:
      * @param host The server host name to connect.
      * @param port The server port to connect.
      * @param timeout The connection time out in miiliseconds.
+     * @param ip The server IP that was resolved or 0 to resolve the host name.
      * @return The socket for success or -1 for error.
      */
-    int start_tcp_connection(ssl_data *ssl, const char *host, uint32_t port, int timeout);
+    int start_tcp_connection(ssl_data *ssl, const char *host, uint32_t port, int timeout, uint32_t ip = 0);
 
     /**
      * Upgrade the current connection by setting up the SSL and perform the SSL handshake.
@@ -130,6 +153,15 @@ public:
      */
     int connect_ssl(ssl_data *ssl, const char *host, const char *rootCABuff, const char *cli_cert, const char *cli_key, const char *pskIdent, const char *psKey, bool insecure);
 
+    /**
+     * Perform the SSL/TLS handshake.
+     *
+     * @param ssl The pointer to ssl data (context).
+     * @param full The full handshake status, set to true when the server sent its certificate.
+     * @return 0 for success or mbedTLS error number.
+     */
+    int ssl_handshake(ssl_data *ssl, bool &full);
+
     /**
      * Stop the TCP connection and release resources.
      *
@@ -192,15 +192,27 @@ bool ESP32_TCP_Client::connect(bool secured, bool verify)
 
     if (connected())
     {
-        flush();
+        if (!keepRxData)
+            flush();
         return true;
     }
 
     if (debugCallback)
         wcs->setDebugCB(&debugCallback);
 
+    // the address is shared with the host check in IMAP idle
+    IPAddress ip;
+    if (cachedHostByName(host.c_str(), ip) != 1)
+        return false;
+
+    wcs->setRemoteIP((uint32_t)ip);
+
     if (!wcs->connect(host.c_str(), this->port))
+    {
+        // resolve again in the next connection, the server address may be changed
+        clearDNSCache();
         return false;
+    }
     return connected();
 }
 
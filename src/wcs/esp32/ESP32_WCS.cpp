@@ -186,7 +186,7 @@ int ESP32_WCS::connect(const char *host, uint16_t port, const char *CA_cert, con
         ssl->handshake_timeout = _timeout;
     }
 
-    int ret = esp32_ssl_client.start_tcp_connection(ssl, host, port, _timeout);
+    int ret = esp32_ssl_client.start_tcp_connection(ssl, host, port, _timeout, _remoteIP);
 
     _lastError = ret;
     if (ret < 0)
@@ -229,7 +229,7 @@ int ESP32_WCS::connect(const char *host, uint16_t port, const char *pskIdent, co
         ssl->handshake_timeout = _timeout;
     }
 
-    int ret = esp32_ssl_client.start_tcp_connection(ssl, host, port, _timeout);
+    int ret = esp32_ssl_client.start_tcp_connection(ssl, host, port, _timeout, _remoteIP);
     _lastError = ret;
     if (ret < 0)
     {
@@ -474,6 +474,11 @@ void ESP32_WCS::setVerify(bool verify)
         _use_insecure = !verify;
 }
 
+void ESP32_WCS::setRemoteIP(uint32_t ip)
+{
+    _remoteIP = ip;
+}
+
 bool ESP32_WCS::isSecure()
 {
     return _secured;
@@ -334,6 +334,12 @@ public:
      */
     void setVerify(bool verify);
 
+    /**
+     * Set the server IP that was resolved for the next connection to the host name.
+     * @param ip The server IP or 0 to resolve the host name when connecting.
+     */
+    void setRemoteIP(uint32_t ip);
+
     /**
      * Get the secure mode connection status.
      * @return The secure mode connection status.
@@ -393,6 +399,7 @@ private:
     MB_String _host;
     MB_String _rxBuf;
     int _port;
+    uint32_t _remoteIP = 0;
 
     /**
      * Get the non-secure mode available data size to read.
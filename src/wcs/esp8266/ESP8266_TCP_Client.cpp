@@ -266,12 +266,24 @@ bool ESP8266_TCP_Client::connect(bool secured, bool verify)
 
   if (connected())
   {
-    flush();
+    if (!keepRxData)
+      flush();
     return true;
   }
 
+  // the address is shared with the host check in IMAP idle
+  IPAddress ip;
+  if (cachedHostByName(host.c_str(), ip) != 1)
+    return false;
+
+  wcs->setRemoteIP((uint32_t)ip);
+
   if (!wcs->connect(host.c_str(), port))
+  {
+    // resolve again in the next connection, the server address may be changed
+    clearDNSCache();
     return false;
+  }
 
   return connected();
 }
@@ -67,9 +67,9 @@ ESP8266_WCS::~ESP8266_WCS()
 int ESP8266_WCS::connect(const char *name, uint16_t port)
 {
 
-  IPAddress remote_addr;
+  IPAddress remote_addr(_remoteIP);
 
-  if (!WiFi.hostByName(name, remote_addr))
+  if (_remoteIP == 0 && !WiFi.hostByName(name, remote_addr))
   {
     DEBUG_BSSL("connect: Name loopup failure\n");
     return 0;
@@ -82,11 +82,12 @@ int ESP8266_WCS::connect(const char *name, uint16_t port)
   }
 
   _host_name = name;
+  _port = port;
 
   if (!_secured)
     return 1;
 
-  return WCS_CLASS::_connectSSL(name);
+  return sslConnect(name);
 }
 
 uint8_t ESP8266_WCS::connected()
@@ -158,6 +159,11 @@ void ESP8266_WCS::setSecure(bool secure)
   _secured = secure;
 }
 
+void ESP8266_WCS::setRemoteIP(uint32_t ip)
+{
+  _remoteIP = ip;
+}
+
 void ESP8266_WCS::setVerify(bool verify)
 {
   if (_has_ta)
@@ -181,12 +187,48 @@ bool ESP8266_WCS::connectSSL(bool verify)
 {
   setVerify(verify);
 
-  bool ret = WCS_CLASS::_connectSSL(_host_name.c_str());
+  bool ret = sslConnect(_host_name.c_str());
   if (ret)
     _secured = true;
   return ret;
 }
 
+bool ESP8266_WCS::sslConnect(const char *host)
+{
+#if defined(ESP_MAIL_USE_TLS_SESSION_CACHE)
+  bool verify = isVerify();
+  // The session parameters are restored from and saved to this session by the handshake
+  BearSSL::Session current;
+  bool cached = session_cache::get(host, _port, verify, [&current](BearSSL::Session &s)
+                                   { current = s; return true; });
+  BearSSL::Session offered = current;
+
+  WCS_CLASS::setSession(&current);
+  bool ret = WCS_CLASS::_connectSSL(host);
+  WCS_CLASS::setSession(nullptr);
+
+  if (!ret)
+  {
+    // The server may not accept the cached session again
+    if (cached)
+      session_cache::remove(host, _port, verify);
+    return false;
+  }
+
+  // The resumed session has the same session ID and master secret
+  bool resumed = cached && memcmp(&offered, &current, sizeof(BearSSL::Session)) == 0;
+  session_cache::addHandshake(cached, resumed);
+  DEBUG_BSSL("connect: TLS session %s\n", resumed ? "resumed" : "created");
+
+  session_cache::add(host, _port, verify, resumed, [&current](BearSSL::Session &s)
+                     { s = current; return true; });
+
+  return true;
+#else
+  return WCS_CLASS::_connectSSL(host);
+#endif
+}
+
 size_t ESP8266_WCS::ns_write(uint8_t b)
 {
   return WCS_CLASS::write(&b, 1);
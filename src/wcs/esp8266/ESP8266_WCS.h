@@ -43,6 +43,7 @@
 #endif
 
 #include "extras/MB_String.h"
+#include "./wcs/base/TLS_Session_Cache.h"
 
 #ifdef DEBUG_ESP_SSL
 #if defined(DEBUG_ESP_PORT)
@@ -156,6 +157,12 @@ public:
    */
   void setVerify(bool verify);
 
+  /**
+   * Set the server IP that was resolved for the next connection to the host name.
+   * @param ip The server IP or 0 to resolve the host name when connecting.
+   */
+  void setRemoteIP(uint32_t ip);
+
   /**
    * Get the secure mode connection status.
    * @return The secure mode connection status.
@@ -176,7 +183,18 @@ public:
    */
   bool connectSSL(bool verify);
 
+#if defined(ESP_MAIL_USE_TLS_SESSION_CACHE)
+  typedef TLS_Session_Cache<BearSSL::Session> session_cache;
+#endif
+
 private:
+  /**
+   * Perform the SSL handshake which resumes the cached session of the server if available.
+   * @param host The server host name.
+   * @return operating result.
+   */
+  bool sslConnect(const char *host);
+
   /**
    * The non-secure mode TCP data write function.
    * @param b The data to write.
@@ -257,6 +275,8 @@ private:
 
   bool _secured = false;
   MB_String _host_name;
+  uint32_t _remoteIP = 0;
+  uint16_t _port = 0;
   bool _has_ta = false;
   bool _base_use_insecure = false;
 };
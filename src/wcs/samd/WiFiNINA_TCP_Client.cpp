@@ -171,7 +171,8 @@ bool WiFiNINA_TCP_Client::connect(bool secured, bool verify)
 
   if (connected())
   {
-    flush();
+    if (!keepRxData)
+      flush();
     return true;
   }
 